@@ -10,6 +10,7 @@
 #include <functional>
 #include <random>
 
+typedef int64_t i64;
 typedef uint64_t u64;
 typedef uint32_t u32;
 typedef uint16_t u16;
@@ -17,7 +18,4 @@ typedef uint8_t u8;
 
 typedef double fp64;
 
-double random_alpha();
-u32 random_int( u32 l, u32 r );
-
 #endif  // __BASIC_HPP__
\ No newline at end of file
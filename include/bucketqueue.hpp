@@ -0,0 +1,185 @@
+#pragma once
+
+#ifndef BUCKET_QUEUE_HPP
+#define BUCKET_QUEUE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+#include "basic.hpp"
+
+/**
+ * Priority queue over the items `0..capacity` with integer keys.
+ *
+ * Every bucket holds an intrusive doubly linked list. Keys below 2^`EXACT_BITS` have a bucket each;
+ * a larger key shares its bucket with the keys of the same bit length that agree in the leading
+ * `EXACT_BITS` + 1 bits, so heavy keys need few buckets and are ordered up to a relative 2^-12.
+ * Every item also carries an age, and `min` breaks ties of equal keys by the lowest age. Buckets are
+ * first in, first out: an item keeps its place while its key stays the same and goes last when the
+ * key changes, so `front` and `successor` list the buckets in order but not their items.
+ * Inserting, re-keying and erasing are O(1). `min` scans the lowest non-empty bucket for the lowest
+ * (key, age), so it costs the size of that bucket plus the empty buckets it skips. The lowest
+ * non-empty bucket is tracked as a bound that is tightened lazily, the highest one only bounds the
+ * scans of `successor` and `clear`.
+ */
+class BucketQueue {
+public:
+    using Item = u32;
+    static constexpr Item NONE = std::numeric_limits<Item>::max();
+    static constexpr u32 EXACT_BITS = 12;
+
+private:
+    std::vector<Item> head_;
+    std::vector<Item> tail_;
+    std::vector<Item> next_;
+    std::vector<Item> prev_;
+    std::vector<u64> key_;
+    std::vector<u64> age_;
+    std::vector<bool> contained_;
+    u32 size_ = 0;
+    u64 min_ = 0;
+    u64 max_ = 0;
+
+    void link( Item item ) {
+        auto b = bucketOf( key_[item] );
+        if ( b >= head_.size() ) {
+            head_.resize( b + 1, NONE );
+            tail_.resize( b + 1, NONE );
+        }
+        prev_[item] = tail_[b];
+        next_[item] = NONE;
+        ( tail_[b] == NONE ? head_[b] : next_[tail_[b]] ) = item;
+        tail_[b] = item;
+        if ( size_ == 0 ) {
+            min_ = max_ = b;
+        } else {
+            min_ = std::min( min_, b );
+            max_ = std::max( max_, b );
+        }
+        size_++;
+    }
+
+    void unlink( Item item ) {
+        auto b = bucketOf( key_[item] );
+        ( prev_[item] == NONE ? head_[b] : next_[prev_[item]] ) = next_[item];
+        ( next_[item] == NONE ? tail_[b] : prev_[next_[item]] ) = prev_[item];
+        size_--;
+    }
+
+    Item firstFrom( u64 b ) const {
+        for ( ; b <= max_ && b < head_.size(); b++ ) {
+            if ( head_[b] != NONE ) {
+                return head_[b];
+            }
+        }
+        return NONE;
+    }
+
+public:
+    // Monotone in `key`, below 64 * 2^EXACT_BITS
+    static inline u64 bucketOf( u64 key ) {
+        if ( key < ( u64( 1 ) << EXACT_BITS ) ) {
+            return key;
+        }
+        // `key >> shift` keeps the leading EXACT_BITS + 1 bits
+        u32 shift = std::bit_width( key ) - EXACT_BITS - 1;
+        return ( u64( shift ) << EXACT_BITS ) + ( key >> shift );
+    }
+
+    BucketQueue() = default;
+    explicit BucketQueue( size_t capacity ) { resize( capacity ); }
+
+    void resize( size_t capacity ) {
+        next_.resize( capacity, NONE );
+        prev_.resize( capacity, NONE );
+        key_.resize( capacity, 0 );
+        age_.resize( capacity, 0 );
+        contained_.resize( capacity, false );
+    }
+
+    inline size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+    inline bool contains( Item item ) const { return item < contained_.size() && contained_[item]; }
+    inline u64 key( Item item ) const { return key_[item]; }
+    inline u64 age( Item item ) const { return age_[item]; }
+
+    /// Inserts `item` last in the bucket of `key`; a queued item keeps its place if `key` is its
+    /// current key and goes last in the bucket of `key` otherwise
+    void update( Item item, u64 key, u64 age ) {
+        assert( item < contained_.size() );
+        age_[item] = age;
+        if ( contained_[item] ) {
+            if ( key == key_[item] ) {
+                return;
+            }
+            unlink( item );
+        }
+        contained_[item] = true;
+        key_[item] = key;
+        link( item );
+    }
+
+    bool erase( Item item ) {
+        if ( !contains( item ) ) {
+            return false;
+        }
+        unlink( item );
+        contained_[item] = false;
+        return true;
+    }
+
+    void clear() {
+        for ( auto b = min_; size_ > 0 && b <= max_; b++ ) {
+            while ( head_[b] != NONE ) {
+                erase( head_[b] );
+            }
+        }
+        min_ = max_ = 0;
+    }
+
+    /// First item of the lowest bucket, NONE if empty
+    Item front() {
+        if ( empty() ) {
+            return NONE;
+        }
+        while ( head_[min_] == NONE ) {
+            min_++;
+        }
+        return head_[min_];
+    }
+
+    /// Item other than `skip` with the lowest (key, age), NONE if there is none
+    Item min( Item skip = NONE ) {
+        if ( front() == NONE ) {
+            return NONE;
+        }
+        // Buckets are monotone in the key, the lowest one holding another item than `skip` has it
+        for ( auto b = min_; b <= max_ && b < head_.size(); b++ ) {
+            Item best = NONE;
+            for ( auto item = head_[b]; item != NONE; item = next_[item] ) {
+                if ( item != skip && ( best == NONE || key_[item] < key_[best] ||
+                                       ( key_[item] == key_[best] && age_[item] < age_[best] ) ) ) {
+                    best = item;
+                }
+            }
+            if ( best != NONE ) {
+                return best;
+            }
+        }
+        return NONE;
+    }
+
+    /// Next item in ascending bucket order after `item`, NONE at the end
+    Item successor( Item item ) const {
+        assert( contains( item ) );
+        if ( next_[item] != NONE ) {
+            return next_[item];
+        }
+        return firstFrom( bucketOf( key_[item] ) + 1 );
+    }
+};
+
+#endif  // BUCKET_QUEUE_HPP
@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+#include <span>
+#include <vector>
+
+#include "basic.hpp"
+#include "instance.hpp"
+#include "nupds.hpp"
+
+/**
+ * Splits an instance into its connected components.
+ *
+ * Every component is a compact instance of its own, numbered 0..k-1, together with the input ids
+ * of its vertices. Components are ordered by decreasing size, which is the order in which `solve`
+ * hands them out, so the largest one never starts last. The instances are only built when there is
+ * more than one component.
+ */
+class Components {
+    size_t count_ = 0;
+    std::vector<Instance> components_;
+    std::vector<std::vector<u32>> ids_;
+
+public:
+    // Throws `std::runtime_error` if an edge or a vertex list refers to a vertex outside the instance
+    explicit Components( const Instance& instance );
+
+    inline size_t size() const { return count_; }
+    inline const Instance& component( size_t i ) const { return components_[i]; }
+    // Input id of every vertex of component `i`
+    inline std::span<const u32> ids( size_t i ) const { return ids_[i]; }
+
+    // Solves every component with a copy of the configured, not yet initialized `prototype` on
+    // `threads` threads and returns the union of the solutions in input ids; needs `size() > 1`.
+    // Rethrows the error of a component that cannot be initialized, see `NuPDS::init`
+    std::vector<unsigned long> solve( const NuPDS& prototype, u32 threads ) const;
+};
+
+#endif  // COMPONENTS_HPP
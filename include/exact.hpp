@@ -0,0 +1,106 @@
+#pragma once
+
+#ifndef EXACT_HPP
+#define EXACT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "basic.hpp"
+#include "lowerbound.hpp"
+#include "pdsgraph.hpp"
+
+/**
+ * Exact branch and bound for power domination.
+ *
+ * A node is the list of decisions leading to it, each one either dominating or excluding a vertex.
+ * Workers own a replica of the graph and move between nodes by rolling back to the common prefix
+ * of the two decision lists and applying the rest, so a step costs about its propagation.
+ * Each worker keeps its unobserved vertices up to date along the path, so a node costs about the
+ * size of the unobserved region. Branching picks the unobserved vertex with the fewest candidates
+ * left in its closed neighborhood and branches on its candidate with the most unobserved neighbors:
+ * dominate it or exclude it. A node is pruned once its dominating vertices plus a `ResidualBound` on the vertices
+ * still missing reach the incumbent, or when that bound shows it cannot be completed.
+ *
+ * Each worker has a deque of open nodes. It works depth first from the back and, when it runs
+ * dry, steals from the front of another worker's deque, where the largest subtrees are.
+ */
+class ExactSolver {
+public:
+    using Vertex = PDSGraph::Vertex;
+    static constexpr Vertex NONE = std::numeric_limits<Vertex>::max();
+
+private:
+    struct Decision {
+        Vertex vertex;
+        bool dominate;
+        inline bool operator==( const Decision& ) const = default;
+    };
+    using Node = std::vector<Decision>;
+
+    struct Worker {
+        PDSGraph graph;
+        std::vector<Decision> path;
+        std::vector<PDSGraph::Checkpoint> checkpoints;
+        std::deque<Node> open;
+        std::mutex mutex;
+        ResidualBound bound;
+        // The unobserved vertices are `order[0 .. unobserved)`. Observing one swaps it behind that
+        // prefix, so going back along `path` only restores the count saved with each checkpoint
+        std::vector<Vertex> order;
+        std::vector<u32> position;
+        u32 unobserved = 0;
+        std::vector<u32> counts;
+        // The unobserved vertices of the current node in ascending order
+        std::vector<Vertex> region;
+
+        explicit Worker( const PDSGraph& base );
+        void observe( std::span<const Vertex> vertices );
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<u8> allowed_;
+    u32 insured_ = 0;
+
+    std::mutex best_mutex_;
+    std::atomic<u32> best_size_;
+    std::vector<Vertex> best_solution_;
+    u32 lower_bound_ = 0;
+
+    std::atomic<u64> pending_ = 0;
+    std::atomic<u64> nodes_ = 0;
+    std::atomic<bool> stop_ = false;
+    std::atomic<bool> timed_out_ = false;
+    std::chrono::steady_clock::time_point deadline_;
+
+    bool canBranch( const PDSGraph& graph, Vertex v ) const;
+    Vertex selectBranchVertex( const PDSGraph& graph, std::span<const Vertex> unobserved ) const;
+    void moveTo( Worker& worker, const Node& node );
+    std::optional<Node> take( u32 id );
+    void expand( u32 id, Node node );
+    void offer( const PDSGraph& graph );
+
+public:
+    // `base` must not dominate anything yet; only `candidates` may enter the solution and
+    // `incumbent` is a known solution (dominating and insured vertices) to prune against
+    ExactSolver( const PDSGraph& base, std::span<const Vertex> candidates,
+                 std::span<const Vertex> incumbent, u32 threads );
+
+    // The search stops as soon as a solution of this size is found
+    inline void setLowerBound( u32 bound ) { lower_bound_ = bound; }
+
+    // Returns true if the solution was proven optimal within `seconds`
+    bool solve( double seconds );
+
+    inline const std::vector<Vertex>& getSolution() const { return best_solution_; }
+    inline u64 numNodes() const { return nodes_; }
+};
+
+#endif  // EXACT_HPP
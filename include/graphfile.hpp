@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef GRAPHFILE_HPP
+#define GRAPHFILE_HPP
+
+#include <ostream>
+#include <span>
+#include <string_view>
+
+#include "basic.hpp"
+#include "instance.hpp"
+#include "pdsgraph.hpp"
+
+/**
+ * Compiled instance, written by the `convert` tool and read without parsing.
+ *
+ * Layout, native byte order, every section starting at a multiple of 8 bytes:
+ * `Header`, title, CSR offsets (u32, n + 1), CSR targets (u32, both arcs of every edge), then
+ * optionally vertex flags (u8, n) and original ids (u32, n). A `GraphFile` is a view of such a
+ * buffer, typically a `MappedFile`, which has to outlive it and every `topology()` taken from it.
+ */
+class GraphFile {
+public:
+    static constexpr char MAGIC[8] = { 'P', 'D', 'S', 'G', 'R', 'A', 'P', 'H' };
+    static constexpr u32 VERSION = 1;
+
+    // Optional sections
+    static constexpr u32 HAS_FLAGS = 1 << 0;
+    static constexpr u32 HAS_IDS = 1 << 1;
+
+    // Vertex flags
+    static constexpr u8 INSURED = 1 << 0;
+    static constexpr u8 EXCLUDED = 1 << 1;
+    static constexpr u8 NON_PROPAGATING = 1 << 2;
+
+    struct Header {
+        char magic[8];
+        u32 version;
+        u32 sections;
+        u64 num_vertices;
+        u64 num_arcs;
+        u32 num_components;
+        u32 title_length;
+    };
+
+private:
+    Header header_;
+    std::string_view title_;
+    std::span<const u32> offsets_;
+    std::span<const u32> targets_;
+    std::span<const u8> flags_;
+    std::span<const u32> ids_;
+
+public:
+    // Whether `data` starts like a compiled instance
+    static bool matches( std::string_view data );
+
+    // Throws `std::runtime_error` if `data` is not a compiled instance of this version, or if its
+    // adjacency lists are not sorted, loop free and symmetric
+    explicit GraphFile( std::string_view data );
+
+    inline std::string_view title() const { return title_; }
+    inline u32 numVertices() const { return header_.num_vertices; }
+    inline u32 numComponents() const { return header_.num_components; }
+    // Zero-copy view of the adjacency
+    inline Topology topology() const { return Topology::view( offsets_, targets_ ); }
+    // Empty if the file has no flags section
+    inline std::span<const u8> flags() const { return flags_; }
+    inline u32 originalId( u32 v ) const { return ids_.empty() ? v : ids_[v]; }
+
+    // Copies the file into an instance, with the vertex numbering of the file
+    Instance toInstance() const;
+
+    // Writes a compiled instance; `flags` and `ids` are left out if empty
+    static void write( std::ostream& out, std::string_view title, const Topology& topology,
+                       u32 components, std::span<const u8> flags, std::span<const u32> ids );
+};
+
+#endif  // GRAPHFILE_HPP
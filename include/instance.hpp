@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef INSTANCE_HPP
+#define INSTANCE_HPP
+
+#include <algorithm>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "basic.hpp"
+#include "loader.hpp"
+
+/**
+ * A problem instance as read from the input, before any solver state is built.
+ *
+ * Vertices are 0..num_vertices-1. The optional lists hold vertices that are already placed
+ * (insured), may not be placed (excluded) and do not propagate.
+ */
+struct Instance {
+    u32 num_vertices = 0;
+    std::vector<std::pair<u32, u32>> edges;
+    std::vector<u32> insured;
+    std::vector<u32> excluded;
+    std::vector<u32> non_propagating;
+
+    // Parses "n m", m edges and up to three lists, each a count followed by vertex ids. Counts only
+    // reserve as much as the rest of the input can hold, a corrupt one fails at the end of the input
+    static Instance parse( Scanner& scanner ) {
+        // Every number takes at least one digit and one separator
+        auto reserve = [&scanner]( auto& vector, u32 count, size_t numbers ) {
+            vector.reserve( std::min<size_t>( count, scanner.remaining() / ( 2 * numbers ) + 1 ) );
+        };
+        Instance instance;
+        instance.num_vertices = scanner.expect();
+        u32 m = scanner.expect();
+        reserve( instance.edges, m, 2 );
+        for ( u32 i = 0; i < m; i++ ) {
+            u32 u = scanner.expect();
+            instance.edges.emplace_back( u, scanner.expect() );
+        }
+        for ( auto* list : { &instance.insured, &instance.excluded, &instance.non_propagating } ) {
+            u32 k;
+            if ( scanner.next( k ) ) {
+                reserve( *list, k, 1 );
+                for ( u32 i = 0; i < k; i++ ) {
+                    list->push_back( scanner.expect() );
+                }
+            }
+        }
+        return instance;
+    }
+
+    // Same as `parse` on the rest of `in`
+    static Instance read( std::istream& in ) {
+        std::string text( std::istreambuf_iterator<char>( in ), {} );
+        Scanner scanner( text );
+        return parse( scanner );
+    }
+};
+
+#endif  // INSTANCE_HPP
@@ -0,0 +1,120 @@
+#pragma once
+
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "basic.hpp"
+
+/**
+ * Read-only view of a whole input file.
+ *
+ * Regular files are memory-mapped, anything else (pipes, devices) is read into an owned buffer.
+ */
+class MappedFile {
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+
+public:
+    // Throws `std::runtime_error` if the file cannot be opened
+    explicit MappedFile( const std::string& path );
+    MappedFile( const MappedFile& ) = delete;
+    MappedFile& operator=( const MappedFile& ) = delete;
+    ~MappedFile();
+
+    inline std::string_view data() const { return { data_, size_ }; }
+};
+
+/**
+ * Whitespace separated tokens of a text buffer, without locales or stream state.
+ * Numbers are unsigned decimal; the digit loop does one subtraction and one compare per character.
+ */
+class Scanner {
+    const char* begin_;
+    const char* cursor_;
+    const char* end_;
+
+    inline void skipSpace() {
+        while ( cursor_ < end_ && static_cast<unsigned char>( *cursor_ ) <= ' ' ) {
+            cursor_++;
+        }
+    }
+
+    // Throws with the byte offset of the cursor in the text
+    [[noreturn]] void fail( const std::string& message ) const {
+        throw std::runtime_error( message + " at offset " + std::to_string( cursor_ - begin_ ) );
+    }
+
+public:
+    explicit Scanner( std::string_view text )
+        : begin_( text.data() ), cursor_( text.data() ), end_( text.data() + text.size() ) {}
+
+    // Bytes not read yet, an upper bound on what the rest of the text can hold
+    inline size_t remaining() const { return end_ - cursor_; }
+
+    inline bool atEnd() {
+        skipSpace();
+        return cursor_ == end_;
+    }
+
+    // Next token as is, empty at the end of the text
+    inline std::string_view word() {
+        skipSpace();
+        auto begin = cursor_;
+        while ( cursor_ < end_ && static_cast<unsigned char>( *cursor_ ) > ' ' ) {
+            cursor_++;
+        }
+        return { begin, static_cast<size_t>( cursor_ - begin ) };
+    }
+
+    // Reads the next number, returns false at the end of the text. The digits have to end the token
+    inline bool next( u32& value ) {
+        skipSpace();
+        auto begin = cursor_;
+        u32 result = 0;
+        while ( cursor_ < end_ ) {
+            u32 digit = static_cast<unsigned char>( *cursor_ ) - '0';
+            if ( digit > 9 ) {
+                break;
+            }
+            if ( result > ( std::numeric_limits<u32>::max() - digit ) / 10 ) {
+                cursor_ = begin;
+                auto token = word();
+                cursor_ = begin;
+                fail( "number out of range: '" + std::string( token ) + "'" );
+            }
+            result = result * 10 + digit;
+            cursor_++;
+        }
+        if ( cursor_ == begin ) {
+            if ( cursor_ == end_ ) {
+                return false;
+            }
+            auto token = word();
+            cursor_ = begin;
+            fail( "expected a number, found '" + std::string( token ) + "'" );
+        }
+        if ( cursor_ < end_ && static_cast<unsigned char>( *cursor_ ) > ' ' ) {
+            fail( "unexpected '" + std::string( 1, *cursor_ ) + "' after a number" );
+        }
+        value = result;
+        return true;
+    }
+
+    // Like `next`, but the number has to be there
+    inline u32 expect() {
+        u32 value;
+        if ( !next( value ) ) {
+            fail( "unexpected end of input" );
+        }
+        return value;
+    }
+};
+
+#endif  // LOADER_HPP
@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef LOWERBOUND_HPP
+#define LOWERBOUND_HPP
+
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "basic.hpp"
+#include "pdsgraph.hpp"
+
+/**
+ * Lower bound on the size of a power dominating set, insured vertices included.
+ *
+ * A leg of `v` is a pendant path attached to `v`. If `v` has at least two legs, every solution
+ * contains `v` or a vertex of one of its legs: the legs can only be entered through `v`, and `v`
+ * forces at most one of its neighbors. These sets are disjoint, so the bound is the number of such
+ * spiders plus the insured vertices outside of them, and at least one per connected component.
+ * Computed in linear time over the frozen topology of the graph.
+ */
+class LowerBound {
+public:
+    using Vertex = PDSGraph::Vertex;
+    static constexpr Vertex NONE = std::numeric_limits<Vertex>::max();
+
+private:
+    u32 components_ = 0;
+    u32 spiders_ = 0;
+    u32 value_ = 0;
+
+    std::vector<u32> legs_;
+    // Vertex a leg vertex is attached to, NONE for every other vertex
+    std::vector<Vertex> attach_;
+    std::vector<u32> component_;
+
+public:
+    explicit LowerBound( const PDSGraph& graph );
+
+    inline u32 value() const { return value_; }
+    inline u32 numComponents() const { return components_; }
+    inline u32 numSpiders() const { return spiders_; }
+};
+
+/**
+ * Lower bound on the number of vertices still missing from a partial solution.
+ *
+ * A fort is a set F of unobserved vertices such that no vertex outside of F which can force has
+ * exactly one neighbor in F. Propagation then never enters F, so every completion contains a vertex
+ * of N[F]. Forts are grown greedily, residual leaves first, and counted while their candidates in
+ * N[F] are disjoint. A fort without candidates proves that the partial solution cannot be completed.
+ * Scratch memory is kept between calls; every call is about linear in the unobserved region.
+ */
+class ResidualBound {
+public:
+    using Vertex = PDSGraph::Vertex;
+    static constexpr Vertex NONE = std::numeric_limits<Vertex>::max();
+    static constexpr u32 INFEASIBLE = std::numeric_limits<u32>::max();
+
+private:
+    // Stamps: `tried_` and `used_` per call, `member_` and `touched_` per grown fort
+    std::vector<u64> tried_;
+    std::vector<u64> used_;
+    std::vector<u64> member_;
+    std::vector<u64> touched_;
+    std::vector<u32> count_;
+    u64 call_ = 0;
+    u64 fort_id_ = 0;
+    std::vector<Vertex> fort_;
+    std::vector<Vertex> pending_;
+
+    // Grows a fort from `seed` into `fort_`; false if it runs into the vertices of an earlier one
+    bool grow( const PDSGraph& graph, Vertex seed );
+
+public:
+    // Only blank or observed vertices `v` with `allowed[v]` may still enter the solution; forts are
+    // seeded from `unobserved`, which lists every unobserved vertex of `graph` in ascending order
+    u32 compute( const PDSGraph& graph, std::span<const u8> allowed,
+                 std::span<const Vertex> unobserved );
+};
+
+#endif  // LOWERBOUND_HPP
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef MOVES_HPP
+#define MOVES_HPP
+
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "basic.hpp"
+#include "pdsgraph.hpp"
+
+/**
+ * Evaluates composite moves on a `PDSGraph` through its undo trail.
+ *
+ * Every move is applied tentatively with `removeDominating` / `setDominating` inside a checkpoint
+ * and rolled back, so evaluating it costs about the size of the region it touches. Candidates are
+ * restricted to that region as well: a vertex entering the solution has to be next to something
+ * the leaving vertices lost, and the second leaving vertex of a 2-1 swap has to be within distance
+ * two of what the first one lost.
+ * The engine only holds scratch memory; the graph is passed to every call and left unchanged.
+ */
+class MoveEngine {
+public:
+    using Vertex = PDSGraph::Vertex;
+    static constexpr Vertex NONE = std::numeric_limits<Vertex>::max();
+
+    // Vertices whose removal loses more than this are not considered for 2-1 swaps: the number of
+    // partner and entry pairs grows with the region and one entering vertex rarely covers it
+    static constexpr size_t MAX_REGION = 64;
+
+    enum class Policy { BestImprovement, FirstImprovement };
+
+    struct Move {
+        Vertex in = NONE;
+        Vertex out = NONE;
+        Vertex out2 = NONE;
+        // Change in the number of observed vertices, or in their weight for the weighted swap
+        i64 delta = 0;
+    };
+
+    // Decides which vertices may enter the solution in a weighted swap
+    using EntryFilter = std::function<bool( Vertex )>;
+
+private:
+    std::vector<Vertex> region_;
+    std::vector<Vertex> partners_;
+    std::vector<Vertex> entries_;
+    mpgraphs::VecSet<Vertex, u32> seen_;
+
+    static inline bool canEnter( const PDSGraph& graph, Vertex v ) {
+        return graph.state( v ) == VertexState::Blank || graph.state( v ) == VertexState::Observed;
+    }
+    void collectEntries( const PDSGraph& graph, Vertex out, Vertex out2 );
+    void collectPartners( const PDSGraph& graph, Vertex out );
+    std::optional<Move> bestEntry( PDSGraph& graph, Move move, u32 before, i64 threshold,
+                                   Policy policy );
+
+public:
+    // Best 1-1 swap of the dominating vertex `out` for a vertex passing `allowed`, scored like a
+    // repair: the entering vertex has to observe strictly more `weight` than `out` loses
+    std::optional<Move> findSwap( PDSGraph& graph, Vertex out, Policy policy,
+                                  const VertexMap<u32>& weight, const EntryFilter& allowed );
+
+    // Best move taking the dominating vertex `out` and one more out for at most one vertex without
+    // observing fewer vertices; a redundant `out` is returned as a move without partner or entry
+    std::optional<Move> findTwoForOne( PDSGraph& graph, Vertex out, Policy policy );
+};
+
+#endif  // MOVES_HPP
@@ -4,17 +4,109 @@
 #ifndef NUPDS_HPP
 #define NUPDS_HPP
 
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <span>
 #include <utility>
 
+#include "bucketqueue.hpp"
+#include "graphfile.hpp"
+#include "instance.hpp"
+#include "moves.hpp"
 #include "pdsgraph.hpp"
+#include "random.hpp"
+#include "reduction.hpp"
+#include "threadpool.hpp"
 #include "utility.hpp"
 
+class SharedBest;
+
 class NuPDS {
 public:
+    static constexpr PDSGraph::Vertex NONE = std::numeric_limits<PDSGraph::Vertex>::max();
+
     PDSGraph pds_graph_;
-    mpgraphs::set<PDSGraph::Vertex> add_available_vertices_;
-    mpgraphs::map<PDSGraph::Vertex, double> remove_available_vertices_;
+    SparseVertexSet add_available_vertices_;
+    SparseVertexSet remove_available_vertices_;
+    // Vertices with an unobserved vertex in their closed neighborhood; only these can have a positive
+    // score, so selection and score invalidation never look past them
+    SparseVertexSet frontier_;
     std::vector<PDSGraph::Vertex> best_solution_;
+    // Insured vertices are part of every solution; counted when the search starts
+    u32 insured_count_ = 0;
+    // Kernelization applied by `preProcess`, lifts solutions back to the input graph
+    Reduction reduction_;
+    // Newly observed count of each candidate, recomputed only when `Node::update` is set
+    VertexMap<u32> score_cache_;
+
+    // Local search state (NuMVC style vertex weighting and configuration checking)
+    VertexMap<u32> weight_;
+    VertexMap<bool> conf_change_;
+    VertexMap<u64> time_stamp_;
+    u64 total_weight_ = 0;
+    u64 step_ = 0;
+    std::optional<PDSGraph::Vertex> tabu_vertex_;
+    std::vector<PDSGraph::Vertex> unobserved_;
+    std::vector<PDSGraph::Vertex> candidates_;
+    // Dominating vertices keyed by weighted loss; ties go to the vertex dominating longest.
+    // Losses near the last move are recomputed lazily, see `refreshLosses`; the others can be stale
+    // and are re-checked when they reach the front, see `selectVertexToRemove`
+    BucketQueue remove_queue_;
+    SparseVertexSet loss_stale_;
+
+    // Closure of the last (de)dominating step, see `getClouser`
+    std::vector<PDSGraph::Vertex> clouser_;
+    mpgraphs::VecSet<PDSGraph::Vertex, u32> in_clouser_;
+
+    double cutoff_ = 10.0;
+    u64 max_iterations_ = std::numeric_limits<u64>::max();
+    std::chrono::steady_clock::time_point start_time_;
+
+    Random rng_;
+
+    // Portfolio mode
+    SharedBest* shared_best_ = nullptr;
+    u64 last_improvement_ = 0;
+    double perturbation_ = 1.0;
+    bool verbose_ = true;
+
+    // Parallel candidate evaluation: replicas of `pds_graph_` for the helper threads of `pool_`,
+    // brought up to date by replaying the moves committed since the last evaluation. A longer log
+    // is dropped and the replicas are copied from `pds_graph_` instead
+    static constexpr size_t PARALLEL_THRESHOLD = 256;
+    static constexpr size_t MAX_PENDING_MOVES = 1 << 14;
+    EvaluationPool pool_;
+    std::vector<PDSGraph> scratch_;
+    std::vector<std::pair<PDSGraph::Vertex, bool>> pending_moves_;
+    bool replicas_stale_ = false;
+    std::vector<PDSGraph::Vertex> stale_;
+    // Perturbation factors of the current `getMaxObserved` candidates, in frontier order
+    std::vector<std::pair<double, PDSGraph::Vertex>> drawn_;
+    std::vector<PDSGraph::Vertex> redundant_;
+    std::vector<u8> removable_;
+
+    MoveEngine moves_;
+    MoveEngine::Policy swap_policy_ = MoveEngine::Policy::FirstImprovement;
+    std::vector<PDSGraph::Vertex> swap_order_;
+
+    // Lazy greedy construction: candidates keyed by their last known perturbed score, only the top
+    // entry is re-simulated. Each candidate's perturbation factor is drawn once per `GRASP` run
+    bool lazy_greedy_ = false;
+    VertexMap<double> lazy_factor_;
+    std::priority_queue<std::pair<double, PDSGraph::Vertex>> lazy_heap_;
+
+    // Exact mode: after the construction, branch and bound on this many threads gets `EXACT_SHARE`
+    // of the time left, with the constructed solution as incumbent. Without a proof the local search
+    // runs in the rest of the time
+    static constexpr double EXACT_SHARE = 0.5;
+    u32 exact_threads_ = 0;
+    bool proven_optimal_ = false;
+    // No solution is smaller, see `LowerBound`; computed when the search starts
+    u32 lower_bound_ = 0;
 
 public:
     NuPDS() = default;
@@ -28,17 +120,77 @@ private:
     std::pair<PDSGraph::Vertex, double> selectVertexToAdd( bool );
     std::pair<PDSGraph::Vertex, double> selectVertexToRemove();
     std::pair<PDSGraph::Vertex, double> getMaxObserved();
-    std::vector<PDSGraph::Vertex> testAddVertex( PDSGraph, PDSGraph::Vertex );
-    void updateAfterDominating( PDSGraph::Vertex vertex, double score,
-                                mpgraphs::set<PDSGraph::Vertex>& newly_observed );
-    void getClouser( PDSGraph::Vertex vertex, mpgraphs::set<PDSGraph::Vertex>& clouser,
-                     mpgraphs::set<PDSGraph::Vertex>& newly_observed );
+    std::pair<PDSGraph::Vertex, double> getLazyMaxObserved();
+    void seedLazyHeap();
+    static u32 testAddVertex( PDSGraph&, PDSGraph::Vertex );
+    void evaluateInParallel( std::vector<PDSGraph::Vertex>& candidates );
+    // Runs `task( graph, i )` for every i < `count` on `pool_`, each thread on an up to date graph
+    void runOnReplicas( size_t count, const std::function<void( PDSGraph&, size_t )>& task );
+    void logMove( PDSGraph::Vertex vertex, bool add );
+    void refreshReplicas();
+    void syncReplica( PDSGraph& graph ) const;
+    static bool isRemovable( PDSGraph&, PDSGraph::Vertex );
+    void filterRemovable( std::vector<PDSGraph::Vertex>& candidates );
+    bool isAllowed( const MoveEngine::Move& move ) const;
+    void applyMove( const MoveEngine::Move& move );
+    std::span<const PDSGraph::Vertex> addToSolution( PDSGraph::Vertex vertex );
+    void removeFromSolution( PDSGraph::Vertex vertex );
+    void updateAfterDominating( PDSGraph::Vertex vertex,
+                                std::span<const PDSGraph::Vertex> newly_observed );
+    void getClouser( std::span<const PDSGraph::Vertex> newly_observed );
+
+    void updateAfterRemoving( PDSGraph::Vertex vertex, std::span<const PDSGraph::Vertex> lost );
+    void invalidateScores();
+    bool onFrontier( PDSGraph::Vertex vertex ) const;
+    void shrinkFrontier( std::span<const PDSGraph::Vertex> newly_observed );
+    void growFrontier( std::span<const PDSGraph::Vertex> lost );
 
-    void updateAfterRemoving( PDSGraph::Vertex vertex );
+    std::pair<PDSGraph::Vertex, double> selectVertexToRepair();
+    u64 weightedGain( PDSGraph::Vertex );
+    u64 weightedLoss( PDSGraph::Vertex );
+    void refreshLosses();
+    void updateWeights();
+    void updateBestSolution();
+    bool timeout() const;
+    std::vector<PDSGraph::Vertex> currentSolution();
+    bool fallenBehind() const;
+    bool boundReached() const;
+    void restart();
+    void initVertices( u32 n );
+    PDSGraph::Vertex checkVertex( u32 id ) const;
+    void initLists( std::span<const u32> insured, std::span<const u32> excluded,
+                    std::span<const u32> non_propagating );
+    // Throws `std::runtime_error` if the excluded vertices leave some vertex unobservable
+    void checkFeasible();
+    void exactSearch( const PDSGraph& base, std::span<const PDSGraph::Vertex> candidates );
 
 public:
+    // Every `init` throws `std::runtime_error` if some vertex cannot be observed at all
     void init( std::ifstream& );
+    void init( const Instance& instance );
+    // Uses the topology of `file` in place, `file` has to outlive the solver and its copies
+    void init( const GraphFile& file );
+    void preProcess();
+    void setCutoff( double seconds, u64 iterations = std::numeric_limits<u64>::max() );
+    inline double getCutoff() const { return cutoff_; }
+    inline void setSharedBest( SharedBest* shared_best ) { shared_best_ = shared_best; }
+    inline void setPerturbation( double perturbation ) { perturbation_ = perturbation; }
+    inline void setVerbose( bool verbose ) { verbose_ = verbose; }
+    inline void setSeed( u64 seed ) { rng_.seed( seed ); }
+    inline void setRandom( const Random& rng ) { rng_ = rng; }
+    inline const Random& getRandom() const { return rng_; }
+    void setEvaluationThreads( u32 threads );
+    inline void setLazyGreedy( bool lazy ) { lazy_greedy_ = lazy; }
+    inline void setSwapPolicy( MoveEngine::Policy policy ) { swap_policy_ = policy; }
+    inline void setExact( u32 threads ) { exact_threads_ = threads; }
+    // Whether the last `search` proved its solution optimal, by the lower bound or in exact mode
+    inline bool isProvenOptimal() const { return proven_optimal_; }
+    inline u32 getLowerBound() const { return lower_bound_; }
     void GRASP();
+    // Drops dominating vertices whose removal loses nothing, returns how many were dropped
+    u32 removeRedundant();
+    // Applies 2-1 swaps until none is left or time runs out, returns how many were applied
+    u32 applySwaps();
     void localSearch();
     void search();
     std::vector<unsigned long> getSolution();
@@ -47,8 +199,8 @@ public:
 public:
     std::vector<PDSGraph::Vertex> setDominating( PDSGraph::Vertex vertex ) {
         auto newly_observed = pds_graph_.setDominating( vertex );
-        updateAfterDominating( vertex, newly_observed.size() * ( 1 + random_alpha() ), newly_observed );
-        return newly_observed | ranges::to<std::vector<PDSGraph::Vertex>>();
+        updateAfterDominating( vertex, newly_observed );
+        return { newly_observed.begin(), newly_observed.end() };
     };
 };
 
@@ -0,0 +1,122 @@
+#pragma once
+
+#ifndef OBSERVATION_FOREST_HPP
+#define OBSERVATION_FOREST_HPP
+
+#include <cassert>
+#include <limits>
+#include <vector>
+
+#include "basic.hpp"
+
+/**
+ * Records which vertex observed which one.
+ *
+ * Every observed vertex has exactly one observer, so the observations form a forest: roots are
+ * observed by themselves (dominating vertices, or vertices whose observer was detached) and the
+ * parent of any other vertex is the vertex that dominated or propagated to it.
+ * Children are kept in intrusive doubly linked lists, so linking and unlinking are O(1).
+ */
+class ObservationForest {
+public:
+    using Vertex = u32;
+    static constexpr Vertex NONE = std::numeric_limits<Vertex>::max();
+
+private:
+    std::vector<Vertex> parent_;
+    std::vector<Vertex> first_child_;
+    std::vector<Vertex> next_sibling_;
+    std::vector<Vertex> prev_sibling_;
+    u32 num_observed_ = 0;
+
+public:
+    struct ChildIterator {
+        const ObservationForest* forest;
+        Vertex v;
+
+        using value_type = Vertex;
+        using difference_type = ssize_t;
+
+        inline Vertex operator*() const { return v; }
+        inline ChildIterator& operator++() {
+            v = forest->next_sibling_[v];
+            return *this;
+        }
+        inline ChildIterator operator++( int ) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+        inline bool operator==( const ChildIterator& other ) const { return v == other.v; }
+    };
+
+    struct ChildRange {
+        ChildIterator first;
+        inline ChildIterator begin() const { return first; }
+        inline ChildIterator end() const { return { first.forest, NONE }; }
+    };
+
+    void resize( size_t n ) {
+        parent_.resize( n, NONE );
+        first_child_.resize( n, NONE );
+        next_sibling_.resize( n, NONE );
+        prev_sibling_.resize( n, NONE );
+    }
+
+    inline size_t capacity() const { return parent_.size(); }
+    inline u32 numObserved() const { return num_observed_; }
+    inline bool isObserved( Vertex v ) const { return parent_[v] != NONE; }
+    inline bool isRoot( Vertex v ) const { return parent_[v] == v; }
+    inline Vertex parent( Vertex v ) const { return parent_[v]; }
+    inline bool hasChildren( Vertex v ) const { return first_child_[v] != NONE; }
+    inline Vertex firstChild( Vertex v ) const { return first_child_[v]; }
+    inline bool hasEdge( Vertex source, Vertex target ) const {
+        return source != target && parent_[target] == source;
+    }
+    inline ChildRange children( Vertex v ) const { return { { this, first_child_[v] } }; }
+
+    // Marks the unobserved vertex `v` as observed root
+    inline void observe( Vertex v ) {
+        assert( !isObserved( v ) );
+        parent_[v] = v;
+        num_observed_++;
+    }
+
+    // Marks the isolated root `v` as unobserved
+    inline void unobserve( Vertex v ) {
+        assert( isRoot( v ) && !hasChildren( v ) );
+        parent_[v] = NONE;
+        num_observed_--;
+    }
+
+    // Makes the root `target` a child of `source`
+    inline void link( Vertex source, Vertex target ) {
+        assert( isRoot( target ) && source != target );
+        parent_[target] = source;
+        prev_sibling_[target] = NONE;
+        next_sibling_[target] = first_child_[source];
+        if ( first_child_[source] != NONE ) {
+            prev_sibling_[first_child_[source]] = target;
+        }
+        first_child_[source] = target;
+    }
+
+    // Detaches `target` from its parent, making it a root
+    inline void cut( Vertex target ) {
+        assert( isObserved( target ) && !isRoot( target ) );
+        auto source = parent_[target];
+        if ( prev_sibling_[target] != NONE ) {
+            next_sibling_[prev_sibling_[target]] = next_sibling_[target];
+        } else {
+            first_child_[source] = next_sibling_[target];
+        }
+        if ( next_sibling_[target] != NONE ) {
+            prev_sibling_[next_sibling_[target]] = prev_sibling_[target];
+        }
+        parent_[target] = target;
+        prev_sibling_[target] = NONE;
+        next_sibling_[target] = NONE;
+    }
+};
+
+#endif  // OBSERVATION_FOREST_HPP
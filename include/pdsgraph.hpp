@@ -2,35 +2,38 @@
 
 #ifndef PDS_HPP
 #define PDS_HPP
+#include <cassert>
 #include <fstream>
+#include <span>
 #include <vector>
 
 #include "basic.hpp"
 #include "common.hpp"
 #include "graph.hpp"
+#include "observationforest.hpp"
+#include "staticgraph.hpp"
 #include "utility.hpp"
 #include "vecgraph.hpp"
 #include "vecset.hpp"
 
-enum class VertexState { Blank = 0, Domating = 1, Observed = 2, Exclude = 3, InSured = 4 };
+enum class VertexState : u8 { Blank = 0, Domating = 1, Observed = 2, Exclude = 3, InSured = 4 };
 
+// Cold per-vertex data; the state read by the search lives in PDSGraph's dense arrays
 struct Node {
-    std::string name;
     u32 id;
-    bool non_propgating;
-    bool update;
-    VertexState state;
 };
 
 using Graph = mpgraphs::VecGraph<Node, mpgraphs::EdgeDirection::Undirected, true, u8, u32>;
-using DenpenceGraph =
-    mpgraphs::VecGraph<mpgraphs::Empty, mpgraphs::EdgeDirection::Bidirectional, true, u8>;
+// Read-only CSR copy of `Graph`'s adjacency used by the propagation loops
+using Topology = mpgraphs::StaticGraph<u32>;
 
 template <typename T>
 using VertexMap = mpgraphs::VecMap<Graph::VertexDescriptor, T, u8>;
 
 using VertexSet = mpgraphs::VecSet<Graph::VertexDescriptor, u8>;
 
+using SparseVertexSet = mpgraphs::SparseSet<Graph::VertexDescriptor>;
+
 using VertexList = std::vector<Graph::VertexDescriptor>;
 
 class PDSGraph {
@@ -38,16 +41,74 @@ public:
     using Vertex = Graph::VertexDescriptor;
 
 public:
-    VertexMap<u32> unobserved_degree_;
+    // Hot per-vertex state as dense arrays indexed by vertex descriptor
+    static constexpr u8 NON_PROPAGATING = 1 << 0;
+    static constexpr u8 UPDATE = 1 << 1;
+    std::vector<VertexState> state_;
+    std::vector<u8> flags_;
+    std::vector<u32> unobserved_degree_;
     u32 dominating_count_ = 0;
     Graph graph_;
-    DenpenceGraph dependencies_;
+    ObservationForest dependencies_;
+    // Rebuilt from `graph_` by `freeze` after the topology changed
+    Topology topology_;
+    bool topology_stale_ = true;
+    // `graph_` holds the vertices but not yet the edges of `topology_`, see `assignTopology`
+    bool edges_pending_ = false;
+
+    /**
+     * Journal of mutations made since the outermost open checkpoint.
+     * Trials are "apply, measure, roll back", so undoing costs only what actually changed.
+     */
+    enum class TrailOp : u8 {
+        State,
+        IncUnobserved,
+        DecUnobserved,
+        Observe,
+        Unobserve,
+        AddObserverEdge,
+        RemoveObserverEdge
+    };
+    struct TrailEntry {
+        TrailOp op;
+        Vertex vertex;
+        Vertex aux;
+    };
+    struct Checkpoint {
+        size_t trail;
+        u32 dominating_count;
+    };
 
 private:
-    void propagate( std::vector<Vertex>& queue, mpgraphs::set<Vertex>& newlyObserved );
+    std::vector<TrailEntry> trail_;
+    u32 open_checkpoints_ = 0;
+
+    inline void record( TrailOp op, Vertex vertex, Vertex aux = 0 ) {
+        if ( open_checkpoints_ > 0 ) {
+            trail_.push_back( { op, vertex, aux } );
+        }
+    }
+    void setState( Vertex v, VertexState state );
+    void incUnobserved( Vertex v );
+    void decUnobserved( Vertex v );
+    void addObserved( Vertex v );
+    void removeObserved( Vertex v );
+    void addObserverEdge( Vertex source, Vertex target );
+    void removeObserverEdge( Vertex source, Vertex target );
+
+    // Workspace reused by every (de)dominating step, so that the search loop does not allocate
+    std::vector<Vertex> queue_;
+    std::vector<Vertex> observed_;
+    std::vector<Vertex> invalid_;
+    std::vector<Vertex> lost_;
+    mpgraphs::VecSet<Vertex, u32> enqueued_;
+    mpgraphs::VecSet<Vertex, u32> expanded_;
+
+    void propagate();
+    // Copies the edges of `topology_` into `graph_` before its first change
+    void materialize();
     // bool observe( Vertex vertex, Vertex origin );
-    bool observeOne( Vertex vertex, Vertex origin, std::vector<Vertex>& queue,
-                     mpgraphs::set<Vertex>& newlyObserved );
+    bool observeOne( Vertex vertex, Vertex origin );
 
 public:
     PDSGraph() = default;
@@ -58,24 +119,58 @@ public:
     PDSGraph& operator=( const PDSGraph& ) = default;
     ~PDSGraph() = default;
 
+    Vertex addVertex( Node node );
     void addEdge( Vertex source, Vertex target );
     void removeVertex( Vertex v );
-
-    mpgraphs::set<Vertex> setDominating( Vertex vertex );
-    bool removeDominating( Vertex vertex );
-
-    inline bool isObserved( Vertex v ) const { return dependencies_.hasVertex( v ); }
-    inline bool isDominating( Vertex v ) const { return graph_[v].state == VertexState::Domating; }
-    inline bool isInSured( Vertex v ) const { return graph_[v].state == VertexState::InSured; }
-    inline bool isBlack( Vertex v ) const { return graph_[v].state == VertexState::Blank; }
-    inline bool isNonPropagating( Vertex v ) const { return graph_[v].non_propgating; }
-    inline bool isUpdate( Vertex v ) const { return graph_[v].update; }
-    inline void setUpdate( Vertex v ) { graph_[v].update = true; }
+    void freeze();
+    // Gives a graph without edges or observed vertices the edges of the symmetric `topology`, e.g. a
+    // view of a mapped file. Only `topology` holds them until `addVertex`, `addEdge` or `removeVertex`
+    // first needs them in `graph_`
+    void assignTopology( Topology topology );
+
+    Checkpoint checkpoint();
+    void rollback( const Checkpoint& cp );
+
+    // Returns the newly observed vertices; the span is valid until the next (de)dominating step
+    std::span<const Vertex> setDominating( Vertex vertex );
+    // Returns the vertices which are no longer observed; the span is valid until the next step
+    std::span<const Vertex> removeDominating( Vertex vertex );
+    // Fixes `vertices` as insured (already placed) dominating vertices and propagates once for all of
+    // them; returns the newly observed vertices like `setDominating`
+    std::span<const Vertex> setInSured( std::span<const Vertex> vertices );
+    // Vertices (re-)observed by the last step, which is what `setDominating` returned; after
+    // `removeDominating` these are the invalidated vertices that were observed again
+    inline std::span<const Vertex> lastObserved() const { return observed_; }
+
+    inline bool isObserved( Vertex v ) const { return dependencies_.isObserved( v ); }
+    inline VertexState state( Vertex v ) const { return state_[v]; }
+    inline bool isDominating( Vertex v ) const { return state_[v] == VertexState::Domating; }
+    inline bool isInSured( Vertex v ) const { return state_[v] == VertexState::InSured; }
+    inline bool isBlack( Vertex v ) const { return state_[v] == VertexState::Blank; }
+    inline bool isNonPropagating( Vertex v ) const { return flags_[v] & NON_PROPAGATING; }
+    inline void setNonPropagating( Vertex v ) { flags_[v] |= NON_PROPAGATING; }
+    // Recorded on the trail like any step, so branching can undo it with `rollback`
+    inline void setExclude( Vertex v ) { setState( v, VertexState::Exclude ); }
+    inline bool isUpdate( Vertex v ) const { return flags_[v] & UPDATE; }
+    inline void setUpdate( Vertex v ) { flags_[v] |= UPDATE; }
+    inline void clearUpdate( Vertex v ) { flags_[v] &= ~UPDATE; }
     inline bool isObervingEdge( Vertex source, Vertex target ) const {
         return dependencies_.hasEdge( source, target );
     }
-    inline u32 unobservedDegree( Vertex v ) const { return unobserved_degree_.at( v ); }
-    inline u32 numObserved() const { return dependencies_.numVertices(); }
+    // Requires an up to date topology, see `freeze`
+    inline std::span<const Vertex> neighbors( Vertex v ) const {
+        assert( !topology_stale_ );
+        return topology_.neighbors( v );
+    }
+    // Current adjacency, unlike `neighbors` also between changes and `freeze`; `neighbor` walks to
+    // the `i`-th neighbor, so it is meant for low degrees
+    inline u32 degree( Vertex v ) const {
+        return edges_pending_ ? topology_.degree( v ) : graph_.degree( v );
+    }
+    Vertex neighbor( Vertex v, u32 i ) const;
+    bool adjacent( Vertex u, Vertex v ) const;
+    inline u32 unobservedDegree( Vertex v ) const { return unobserved_degree_[v]; }
+    inline u32 numObserved() const { return dependencies_.numObserved(); }
     inline bool allObserved() const { return numObserved() == graph_.numVertices(); }
 
 public:
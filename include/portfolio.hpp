@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+#include "basic.hpp"
+#include "nupds.hpp"
+
+/**
+ * Size of the best solution found by any worker of a portfolio.
+ * Workers publish improvements with `offer` and poll `get` without locking.
+ */
+class SharedBest {
+    std::atomic<u32> size_{ std::numeric_limits<u32>::max() };
+
+public:
+    inline u32 get() const { return size_.load( std::memory_order_relaxed ); }
+
+    // Returns whether `size` is the new shared best
+    inline bool offer( u32 size ) {
+        u32 current = get();
+        while ( size < current ) {
+            if ( size_.compare_exchange_weak( current, size, std::memory_order_relaxed ) ) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * Runs independent GRASP + local search workers on copies of an initialized solver.
+ * Each worker has its own construction strategy and a random stream split from the prototype's
+ * generator.
+ */
+class Portfolio {
+    std::vector<NuPDS> workers_;
+    SharedBest shared_best_;
+
+public:
+    Portfolio( const NuPDS& prototype, u32 threads );
+
+    void search();
+    std::vector<unsigned long> getSolution();
+};
+
+#endif  // PORTFOLIO_HPP
@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <array>
+#include <limits>
+
+#include "basic.hpp"
+
+/**
+ * xoshiro256** generator (Blackman & Vigna) seeded through splitmix64.
+ * Each solver owns one instance; `split` derives independent streams for parallel workers
+ * by jumping 2^128 draws ahead.
+ */
+class Random {
+    std::array<u64, 4> s_;
+
+    static inline u64 rotl( u64 x, int k ) { return ( x << k ) | ( x >> ( 64 - k ) ); }
+
+public:
+    using result_type = u64;
+
+    explicit Random( u64 seed = 0 ) { this->seed( seed ); }
+
+    void seed( u64 seed ) {
+        for ( auto& s : s_ ) {
+            // splitmix64
+            u64 z = ( seed += 0x9e3779b97f4a7c15 );
+            z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9;
+            z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111eb;
+            s = z ^ ( z >> 31 );
+        }
+    }
+
+    inline u64 next() {
+        u64 result = rotl( s_[1] * 5, 7 ) * 9;
+        u64 t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl( s_[3], 45 );
+        return result;
+    }
+
+    inline u64 operator()() { return next(); }
+    static constexpr u64 min() { return 0; }
+    static constexpr u64 max() { return std::numeric_limits<u64>::max(); }
+
+    // Uniform integer in [0, n), Lemire's multiply-shift without the rejection step
+    inline u32 nextBounded( u32 n ) { return static_cast<u32>( ( ( next() >> 32 ) * n ) >> 32 ); }
+
+    // Uniform integer in [l, r]
+    inline u32 nextInt( u32 l, u32 r ) { return l + nextBounded( r - l + 1 ); }
+
+    // Uniform double in [0, 1)
+    inline double nextDouble() { return ( next() >> 11 ) * 0x1.0p-53; }
+
+    // Advances the state by 2^128 draws
+    void jump() {
+        constexpr u64 JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa,
+                                 0x39abdc4529b1661c };
+        std::array<u64, 4> s{};
+        for ( u64 word : JUMP ) {
+            for ( int b = 0; b < 64; b++ ) {
+                if ( word & ( u64{ 1 } << b ) ) {
+                    for ( int i = 0; i < 4; i++ ) {
+                        s[i] ^= s_[i];
+                    }
+                }
+                next();
+            }
+        }
+        s_ = s;
+    }
+
+    // Returns the `index`-th stream which does not overlap with this one
+    Random split( u32 index ) const {
+        Random stream = *this;
+        for ( u32 i = 0; i <= index; i++ ) {
+            stream.jump();
+        }
+        return stream;
+    }
+};
+
+#endif  // RANDOM_HPP
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef REDUCTION_HPP
+#define REDUCTION_HPP
+
+#include <span>
+#include <vector>
+
+#include "basic.hpp"
+#include "pdsgraph.hpp"
+#include "vecset.hpp"
+
+/**
+ * Safe power domination reductions, applied to a `PDSGraph` before the search.
+ *
+ * - DeleteLeaf: a leaf whose neighbor has degree at most two is deleted. The neighbor observes
+ *   whatever the leaf would and, once its other neighbor is observed, propagates to the leaf anyway.
+ *   Repeated, this shrinks every pendant path to a single leaf.
+ * - ContractChain: a degree-two vertex between two degree-two vertices is removed and its neighbors
+ *   are joined. Any observed vertex of a chain observes the whole chain and both of its ends, so
+ *   chains behave the same for every length of at least two.
+ * - ExcludeLeaf: a remaining leaf is never needed, its neighbor observes a superset of it.
+ * - ForceIsolated: an isolated vertex can only be observed by itself; it is removed and put into
+ *   every lifted solution.
+ *
+ * Rules only touch vertices that are blank, unobserved and propagating, so they compose with
+ * insured, excluded and non-propagating vertices of the input. Vertex ids are kept, which makes a
+ * solution of the reduced graph valid for the original one once the forced vertices are added.
+ */
+class Reduction {
+public:
+    using Vertex = PDSGraph::Vertex;
+
+    enum class Rule : u8 { DeleteLeaf, ContractChain, ExcludeLeaf, ForceIsolated };
+
+    struct Step {
+        Rule rule;
+        Vertex vertex;
+    };
+
+private:
+    std::vector<Step> log_;
+    std::vector<Vertex> queue_;
+    mpgraphs::VecSet<Vertex, u32> queued_;
+
+    static bool isReducible( const PDSGraph& graph, Vertex v );
+    void push( Vertex v );
+    bool deleteLeaf( PDSGraph& graph, Vertex v );
+    bool contractChain( PDSGraph& graph, Vertex v );
+
+public:
+    // Reduces `graph` in place and returns the number of removed vertices
+    size_t apply( PDSGraph& graph );
+
+    // Maps a solution of the reduced graph to one of the original graph
+    void lift( std::vector<Vertex>& solution ) const;
+
+    inline std::span<const Step> log() const { return log_; }
+};
+
+#endif  // REDUCTION_HPP
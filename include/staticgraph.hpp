@@ -0,0 +1,255 @@
+#ifndef MPGRAPHS_STATICGRAPH_HPP
+#define MPGRAPHS_STATICGRAPH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mpgraphs {
+
+/**
+ * Immutable graph in compressed sparse row format.
+ *
+ * The neighbors of vertex `v` are `targets[offsets[v] .. offsets[v + 1])`, so all adjacency lists
+ * lie contiguously in memory. Undirected graphs store both arcs of every edge.
+ * Vertex descriptors are the indices `0 .. numVertices()`; vertices missing from the source graph
+ * are kept as isolated vertices.
+ *
+ * The arrays are either owned or, for a graph created by `view`, borrowed from memory that outlives
+ * the graph, e.g. a memory-mapped file. Copies of a view are views of the same memory.
+ *
+ * @tparam Unsigned type of vertex descriptors and offsets
+ */
+template<std::unsigned_integral Unsigned = uint32_t>
+class StaticGraph {
+public:
+    using VertexDescriptor = Unsigned;
+
+    /**
+     * Edge lists of at least this many edges are built in parallel by `fromEdges`.
+     */
+    static constexpr size_t PARALLEL_THRESHOLD = size_t{1} << 20;
+
+private:
+    std::vector<Unsigned> m_offsetStorage;
+    std::vector<Unsigned> m_targetStorage;
+    std::span<const Unsigned> m_offsets;
+    std::span<const Unsigned> m_targets;
+    bool m_view = false;
+
+    void bind() {
+        if (!m_view) {
+            m_offsets = m_offsetStorage;
+            m_targets = m_targetStorage;
+        }
+    }
+
+    void assign(const StaticGraph& other) {
+        m_view = other.m_view;
+        m_offsetStorage = other.m_offsetStorage;
+        m_targetStorage = other.m_targetStorage;
+        m_offsets = other.m_offsets;
+        m_targets = other.m_targets;
+        bind();
+    }
+
+public:
+    /**
+     * Create an empty graph.
+     */
+    StaticGraph() : StaticGraph(std::vector<Unsigned>(1, 0), {}) { }
+
+    /**
+     * Create a graph from its CSR arrays. `offsets` has one entry more than there are vertices.
+     */
+    StaticGraph(std::vector<Unsigned> offsets, std::vector<Unsigned> targets)
+        : m_offsetStorage(std::move(offsets)), m_targetStorage(std::move(targets)) {
+        assert(!m_offsetStorage.empty() && m_offsetStorage.back() == m_targetStorage.size());
+        bind();
+    }
+
+    /**
+     * Create a graph on borrowed CSR arrays, nothing is copied.
+     */
+    static StaticGraph view(std::span<const Unsigned> offsets, std::span<const Unsigned> targets) {
+        assert(!offsets.empty() && offsets.back() == targets.size());
+        StaticGraph graph;
+        graph.m_offsetStorage.clear();
+        graph.m_offsets = offsets;
+        graph.m_targets = targets;
+        graph.m_view = true;
+        return graph;
+    }
+
+    StaticGraph(const StaticGraph& other) { assign(other); }
+    StaticGraph(StaticGraph&& other) { *this = std::move(other); }
+    StaticGraph& operator=(const StaticGraph& other) {
+        if (this != &other) {
+            assign(other);
+        }
+        return *this;
+    }
+    StaticGraph& operator=(StaticGraph&& other) {
+        m_view = other.m_view;
+        m_offsetStorage = std::move(other.m_offsetStorage);
+        m_targetStorage = std::move(other.m_targetStorage);
+        m_offsets = other.m_offsets;
+        m_targets = other.m_targets;
+        bind();
+        return *this;
+    }
+
+    /**
+     * Returns whether the arrays are borrowed, see `view`.
+     */
+    inline bool isView() const { return m_view; }
+
+    /**
+     * Copy the adjacency of `graph`, e.g. a `VecGraph`, whose vertex descriptors are less than
+     * `capacity`.
+     */
+    template<class Graph>
+    static StaticGraph fromGraph(const Graph& graph, size_t capacity) {
+        std::vector<Unsigned> offsets(capacity + 1, 0);
+        for (auto v: graph.vertices()) {
+            offsets[v + 1] = graph.outDegree(v);
+        }
+        for (size_t v = 0; v < capacity; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<Unsigned> targets(offsets.back());
+        for (auto v: graph.vertices()) {
+            auto it = targets.begin() + offsets[v];
+            for (auto w: graph.neighbors(v)) {
+                *it++ = static_cast<Unsigned>(w);
+            }
+        }
+        return StaticGraph(std::move(offsets), std::move(targets));
+    }
+
+    /**
+     * Build a graph from an edge list in bulk: count the degrees, lay the arrays out once, scatter
+     * the arcs and sort and deduplicate every adjacency list. Self loops are dropped. `symmetric`
+     * stores every edge in both directions, as needed for undirected graphs. Lists of at least
+     * `PARALLEL_THRESHOLD` edges are processed on `threads` threads, 0 meaning one per core.
+     *
+     * *Time Complexity:* O(m log Δ)
+     */
+    static StaticGraph fromEdges(size_t numVertices, std::span<const std::pair<Unsigned, Unsigned>> edges,
+                                 bool symmetric = true, unsigned threads = 0) {
+        if (edges.size() < PARALLEL_THRESHOLD) {
+            threads = 1;
+        } else if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // Runs `body(begin, end)` on `threads` contiguous chunks of [0, count)
+        auto parallel = [threads](size_t count, auto body) {
+            if (threads == 1) {
+                body(size_t{0}, count);
+                return;
+            }
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back(body, count * t / threads, count * (t + 1) / threads);
+            }
+            for (auto& worker: workers) {
+                worker.join();
+            }
+        };
+        auto increment = [threads](Unsigned& counter) {
+            if (threads == 1) {
+                return counter++;
+            }
+            return std::atomic_ref<Unsigned>(counter).fetch_add(1, std::memory_order_relaxed);
+        };
+
+        std::vector<Unsigned> offsets(numVertices + 1, 0);
+        parallel(edges.size(), [&](size_t begin, size_t end) {
+            for (auto [u, v]: edges.subspan(begin, end - begin)) {
+                assert(u < numVertices && v < numVertices);
+                if (u != v) {
+                    increment(offsets[u + 1]);
+                    if (symmetric) {
+                        increment(offsets[v + 1]);
+                    }
+                }
+            }
+        });
+        for (size_t v = 0; v < numVertices; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+
+        std::vector<Unsigned> targets(offsets.back());
+        std::vector<Unsigned> cursor(offsets.begin(), offsets.end() - 1);
+        parallel(edges.size(), [&](size_t begin, size_t end) {
+            for (auto [u, v]: edges.subspan(begin, end - begin)) {
+                if (u != v) {
+                    targets[increment(cursor[u])] = v;
+                    if (symmetric) {
+                        targets[increment(cursor[v])] = u;
+                    }
+                }
+            }
+        });
+
+        // `cursor` becomes the deduplicated degree
+        parallel(numVertices, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                auto first = targets.begin() + offsets[v];
+                auto last = targets.begin() + offsets[v + 1];
+                std::sort(first, last);
+                cursor[v] = std::unique(first, last) - first;
+            }
+        });
+        std::vector<Unsigned> compact(numVertices + 1, 0);
+        for (size_t v = 0; v < numVertices; ++v) {
+            compact[v + 1] = compact[v] + cursor[v];
+        }
+        if (compact.back() == targets.size()) {
+            return StaticGraph(std::move(offsets), std::move(targets));
+        }
+        std::vector<Unsigned> compactTargets(compact.back());
+        parallel(numVertices, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                std::copy_n(targets.begin() + offsets[v], cursor[v], compactTargets.begin() + compact[v]);
+            }
+        });
+        return StaticGraph(std::move(compact), std::move(compactTargets));
+    }
+
+    /**
+     * Returns the number of vertex descriptors.
+     */
+    inline size_t numVertices() const { return m_offsets.size() - 1; }
+
+    /**
+     * Returns the number of stored arcs (twice the number of edges for undirected graphs).
+     */
+    inline size_t numArcs() const { return m_targets.size(); }
+
+    inline bool hasVertex(VertexDescriptor v) const { return v < numVertices(); }
+
+    /**
+     * Returns the neighbors of `v` as a contiguous range.
+     */
+    inline std::span<const Unsigned> neighbors(VertexDescriptor v) const {
+        assert(hasVertex(v));
+        return {m_targets.data() + m_offsets[v], m_targets.data() + m_offsets[v + 1]};
+    }
+
+    inline Unsigned degree(VertexDescriptor v) const {
+        assert(hasVertex(v));
+        return m_offsets[v + 1] - m_offsets[v];
+    }
+
+    inline std::span<const Unsigned> offsets() const { return m_offsets; }
+    inline std::span<const Unsigned> targets() const { return m_targets; }
+};
+} // namespace mpgraphs
+
+#endif //MPGRAPHS_STATICGRAPH_HPP
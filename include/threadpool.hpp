@@ -0,0 +1,111 @@
+#pragma once
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "basic.hpp"
+
+/**
+ * Fixed set of threads which all execute the same task, as in an OpenMP parallel region.
+ * The calling thread takes part as thread 0, so a pool of size 1 spawns no thread at all.
+ */
+class ThreadPool {
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::function<void( u32 )> task_;
+    u64 generation_ = 0;
+    u32 running_ = 0;
+    bool stop_ = false;
+
+    void work( u32 id ) {
+        u64 seen = 0;
+        while ( true ) {
+            std::unique_lock lock( mutex_ );
+            wake_.wait( lock, [&]() { return stop_ || generation_ != seen; } );
+            if ( stop_ ) {
+                return;
+            }
+            seen = generation_;
+            lock.unlock();
+            task_( id );
+            lock.lock();
+            if ( --running_ == 0 ) {
+                done_.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool( u32 threads ) {
+        for ( u32 id = 1; id < threads; id++ ) {
+            threads_.emplace_back( [this, id]() { work( id ); } );
+        }
+    }
+
+    ThreadPool( const ThreadPool& ) = delete;
+    ThreadPool& operator=( const ThreadPool& ) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock( mutex_ );
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for ( auto& thread : threads_ ) {
+            thread.join();
+        }
+    }
+
+    inline u32 size() const { return threads_.size() + 1; }
+
+    // Runs `task( id )` for every thread id in [0, size()) and waits until all of them returned
+    void run( std::function<void( u32 )> task ) {
+        {
+            std::lock_guard lock( mutex_ );
+            task_ = std::move( task );
+            running_ = threads_.size();
+            generation_++;
+        }
+        wake_.notify_all();
+        task_( 0 );
+        std::unique_lock lock( mutex_ );
+        done_.wait( lock, [&]() { return running_ == 0; } );
+    }
+};
+
+/**
+ * Optional pool owned by a single object. Concurrent `run` calls on one pool race, so a copy of the
+ * owner starts threads of its own instead of sharing them.
+ */
+class EvaluationPool {
+    std::unique_ptr<ThreadPool> pool_;
+
+public:
+    EvaluationPool() = default;
+    explicit EvaluationPool( u32 threads ) : pool_( std::make_unique<ThreadPool>( threads ) ) {}
+
+    EvaluationPool( const EvaluationPool& other )
+        : pool_( other.pool_ ? std::make_unique<ThreadPool>( other.pool_->size() ) : nullptr ) {}
+    EvaluationPool( EvaluationPool&& ) = default;
+    EvaluationPool& operator=( EvaluationPool&& ) = default;
+    EvaluationPool& operator=( const EvaluationPool& other ) {
+        if ( this != &other ) {
+            pool_ = other.pool_ ? std::make_unique<ThreadPool>( other.pool_->size() ) : nullptr;
+        }
+        return *this;
+    }
+
+    inline explicit operator bool() const { return pool_ != nullptr; }
+    inline ThreadPool* operator->() const { return pool_.get(); }
+};
+
+#endif  // THREADPOOL_HPP
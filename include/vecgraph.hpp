@@ -387,6 +387,40 @@ public:
         }
     }
 
+    /**
+     * Sets the neighbors of the isolated vertex `vertex` to `neighbors` in one step.
+     * Nothing is checked: the range must be free of duplicates and, since both arcs of an edge are
+     * stored, the caller assigns the reverse arcs as well, e.g. by copying a symmetric CSR graph.
+     *
+     * *Time Complexity:* O(|neighbors|)
+     */
+    template<class Range>
+    void assignNeighbors(VertexDescriptor vertex, const Range& neighbors) requires (Dir == EdgeDirection::Undirected) {
+        assert(hasVertex(vertex) && m_vertices.at(vertex).outNeighbors.empty());
+        auto& entry = m_vertices.at(vertex);
+        entry.outNeighbors.assign(ranges::begin(neighbors), ranges::end(neighbors));
+        entry.inDegree = entry.outNeighbors.size();
+        // Every edge is counted once, from its smaller endpoint
+        for (auto w: entry.outNeighbors) {
+            m_numEdges += (vertex <= w);
+        }
+    }
+
+    /**
+     * Copies every adjacency list of the symmetric static graph `graph`, e.g. a `StaticGraph`, into
+     * this graph, which must not have edges yet. Vertices missing from either graph are skipped.
+     *
+     * *Time Complexity:* O(n + m)
+     */
+    template<class Static>
+    void assignEdges(const Static& graph) requires (Dir == EdgeDirection::Undirected) {
+        for (auto v: vertices()) {
+            if (v < graph.numVertices()) {
+                assignNeighbors(v, graph.neighbors(v));
+            }
+        }
+    }
+
     /**
      * Removes an edge fom `u` to `v`, if present.
      * @see removeEdge(EdgeDescriptor)
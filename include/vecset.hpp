@@ -4,7 +4,9 @@
 #ifndef PDS_VECSET_HPP
 #define PDS_VECSET_HPP
 
+#include <algorithm>
 #include <vector>
+#include <limits>
 #include <memory>
 #include <type_traits>
 #include <cassert>
@@ -121,9 +123,11 @@ public:
 
     inline size_t capacity() const noexcept { return m_present.size(); }
 
+    /// *Time Complexity:* O(1), O(capacity()) once every MAX_TIMESTAMP - 1 clears when the timestamp wraps
     void clear() {
         if (m_timestamp == MAX_TIMESTAMP) {
-            m_present.clear();
+            std::fill(m_present.begin(), m_present.end(), MIN_TIMESTAMP);
+            m_timestamp = INITIAL_TIMESTAMP;
             m_size = 0;
         } else {
             m_timestamp = m_timestamp + 1;
@@ -170,6 +174,95 @@ private:
     std::vector <Timestamp> m_present;
     Timestamp m_timestamp;
 };
+
+/**
+ * Set of integers from [0, capacity) with O(1) insert, erase, contains and random access.
+ *
+ * Elements are stored contiguously in a dense array (`erase` moves the last element into the gap),
+ * and `m_position` maps every key to its index in the dense array.
+ * Iteration order is the order of the dense array and changes with `erase`.
+ */
+template<std::integral T>
+class SparseSet {
+    static constexpr const T NONE = std::numeric_limits<T>::max();
+
+    inline bool validKey(const T &x) const { return x >= 0 && static_cast<size_t>(x) < m_position.size(); }
+
+public:
+    using iterator = typename std::vector<T>::const_iterator;
+    using const_iterator = iterator;
+
+    SparseSet(size_t capacity) : m_dense(), m_position(capacity, NONE) { }
+    SparseSet() : SparseSet(0) { }
+
+    SparseSet(const SparseSet &other) = default;
+
+    SparseSet(SparseSet &&other) = default;
+
+    SparseSet &operator=(const SparseSet &) = default;
+
+    SparseSet &operator=(SparseSet &&) = default;
+
+    inline bool empty() const { return m_dense.empty(); }
+    inline size_t size() const { return m_dense.size(); }
+    inline size_t capacity() const noexcept { return m_position.size(); }
+
+    void reserve(size_t maxCapacity) {
+        if (capacity() < maxCapacity) {
+            m_position.resize(maxCapacity, NONE);
+            m_dense.reserve(maxCapacity);
+        }
+    }
+
+    const_iterator begin() const { return m_dense.begin(); }
+    const_iterator end() const { return m_dense.end(); }
+
+    /// Returns the `i`-th element of the dense array, with `i` < `size()`
+    inline T operator[](size_t i) const {
+        assert(i < size());
+        return m_dense[i];
+    }
+
+    /// *Time Complexity:* O(size())
+    void clear() {
+        for (auto x: m_dense) {
+            m_position[x] = NONE;
+        }
+        m_dense.clear();
+    }
+
+    /// Returns whether `x` was inserted
+    bool insert(const T &x) {
+        assert(x >= 0);
+        if (!validKey(x)) {
+            // Geometric growth, ascending insertions into an unreserved set stay amortized O(1)
+            reserve(std::max(static_cast<size_t>(x) + 1, 2 * capacity()));
+        }
+        if (contains(x)) return false;
+        m_position[x] = static_cast<T>(m_dense.size());
+        m_dense.push_back(x);
+        return true;
+    }
+
+    /// Returns whether `x` was erased
+    bool erase(const T &x) {
+        if (!contains(x)) return false;
+        T last = m_dense.back();
+        m_dense[m_position[x]] = last;
+        m_position[last] = m_position[x];
+        m_position[x] = NONE;
+        m_dense.pop_back();
+        return true;
+    }
+
+    inline bool contains(const T &x) const { return validKey(x) && m_position[x] != NONE; }
+
+    inline size_t count(const T &x) const { return contains(x); }
+
+private:
+    std::vector<T> m_dense;
+    std::vector<T> m_position;
+};
 } // namespace mpgraphs
 
 #endif //PDS_VECSET_HPP
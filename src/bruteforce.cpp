@@ -0,0 +1,405 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "basic.hpp"
+#include "bucketqueue.hpp"
+#include "instance.hpp"
+#include "lowerbound.hpp"
+#include "nupds.hpp"
+#include "random.hpp"
+
+// Compares the solver against brute force on small random instances:
+//   bruteforce [instances] [seed]
+// Initialization has to reject exactly the instances without a solution. The exact search, with and
+// without kernelization, must find an optimal solution and prove it, the lower bound must not exceed
+// the optimum, and `removeDominating` must leave the same observed set as dominating the remaining
+// vertices from scratch. The data structures and the parallel graph build are checked against simple
+// references on the side.
+
+namespace {
+
+constexpr u32 NONE = std::numeric_limits<u32>::max();
+
+// A random tree with a few extra edges, so there are pendant paths, chains and some cycles
+Instance randomInstance( Random& rng, u32 num_vertices, bool lists ) {
+    Instance instance;
+    instance.num_vertices = num_vertices;
+    for ( u32 v = 1; v < num_vertices; v++ ) {
+        if ( rng.nextDouble() < 0.8 ) {
+            instance.edges.emplace_back( rng.nextBounded( v ), v );
+        }
+    }
+    for ( u32 i = rng.nextBounded( 4 ); i > 0; i-- ) {
+        u32 u = rng.nextBounded( num_vertices ), v = rng.nextBounded( num_vertices );
+        auto known = [&]( auto& e ) {
+            return ( e.first == u && e.second == v ) || ( e.first == v && e.second == u );
+        };
+        if ( u != v && std::none_of( instance.edges.begin(), instance.edges.end(), known ) ) {
+            instance.edges.emplace_back( u, v );
+        }
+    }
+    if ( lists ) {
+        std::vector<u32> order( num_vertices );
+        for ( u32 v = 0; v < num_vertices; v++ ) {
+            order[v] = v;
+        }
+        for ( u32 i = num_vertices - 1; i > 0; i-- ) {
+            std::swap( order[i], order[rng.nextBounded( i + 1 )] );
+        }
+        // Disjoint picks from a shuffled order; non-propagating vertices may also be insured
+        auto it = order.begin();
+        instance.insured.assign( it, it + rng.nextBounded( 2 ) );
+        it += instance.insured.size();
+        instance.excluded.assign( it, it + rng.nextBounded( 3 ) );
+        instance.non_propagating.assign( order.begin(), order.begin() + rng.nextBounded( 3 ) );
+    }
+    return instance;
+}
+
+bool contains( const std::vector<u32>& list, u32 v ) {
+    return std::find( list.begin(), list.end(), v ) != list.end();
+}
+
+bool observesAll( const Instance& instance, const std::vector<std::vector<u32>>& adjacency,
+                  const std::vector<bool>& chosen ) {
+    u32 n = instance.num_vertices;
+    std::vector<bool> observed( n, false );
+    for ( u32 v = 0; v < n; v++ ) {
+        if ( chosen[v] ) {
+            observed[v] = true;
+            for ( auto w : adjacency[v] ) {
+                observed[w] = true;
+            }
+        }
+    }
+    for ( bool changed = true; changed; ) {
+        changed = false;
+        for ( u32 v = 0; v < n; v++ ) {
+            if ( !observed[v] || contains( instance.non_propagating, v ) ) {
+                continue;
+            }
+            u32 unobserved = NONE, count = 0;
+            for ( auto w : adjacency[v] ) {
+                if ( !observed[w] ) {
+                    unobserved = w;
+                    count++;
+                }
+            }
+            if ( count == 1 ) {
+                observed[unobserved] = true;
+                changed = true;
+            }
+        }
+    }
+    return std::all_of( observed.begin(), observed.end(), []( bool o ) { return o; } );
+}
+
+// Whether `solution` holds every insured and no excluded vertex and observes the whole graph
+bool isFeasible( const Instance& instance, const std::vector<std::vector<u32>>& adjacency,
+                 const std::vector<unsigned long>& solution ) {
+    std::vector<bool> chosen( instance.num_vertices, false );
+    for ( auto v : solution ) {
+        if ( v >= instance.num_vertices || contains( instance.excluded, v ) ) {
+            return false;
+        }
+        chosen[v] = true;
+    }
+    for ( auto v : instance.insured ) {
+        if ( !chosen[v] ) {
+            return false;
+        }
+    }
+    return observesAll( instance, adjacency, chosen );
+}
+
+// Size of a smallest solution, NONE if there is none; tries all subsets by increasing size
+u32 optimum( const Instance& instance, const std::vector<std::vector<u32>>& adjacency ) {
+    std::vector<u32> free;
+    for ( u32 v = 0; v < instance.num_vertices; v++ ) {
+        if ( !contains( instance.insured, v ) && !contains( instance.excluded, v ) ) {
+            free.push_back( v );
+        }
+    }
+    for ( u32 k = 0; k <= free.size(); k++ ) {
+        std::vector<bool> mask( free.size(), false );
+        std::fill( mask.begin(), mask.begin() + k, true );
+        do {
+            std::vector<bool> chosen( instance.num_vertices, false );
+            for ( auto v : instance.insured ) {
+                chosen[v] = true;
+            }
+            for ( u32 i = 0; i < free.size(); i++ ) {
+                chosen[free[i]] = mask[i];
+            }
+            if ( observesAll( instance, adjacency, chosen ) ) {
+                return k + instance.insured.size();
+            }
+        } while ( std::prev_permutation( mask.begin(), mask.end() ) );
+    }
+    return NONE;
+}
+
+// `init` has to reject exactly the instances without a solution
+std::optional<std::string> checkInit( const Instance& instance, bool feasible ) {
+    NuPDS solver;
+    try {
+        solver.init( instance );
+    } catch ( const std::runtime_error& ) {
+        return feasible ? std::optional<std::string>( "feasible instance rejected" ) : std::nullopt;
+    }
+    return feasible ? std::nullopt : std::optional<std::string>( "infeasible instance accepted" );
+}
+
+std::optional<std::string> checkExact( const Instance& instance,
+                                       const std::vector<std::vector<u32>>& adjacency, u32 best,
+                                       bool reduce, u32 threads ) {
+    NuPDS solver;
+    solver.setVerbose( false );
+    solver.setCutoff( 10 );
+    solver.init( instance );
+    if ( reduce ) {
+        solver.preProcess();
+    }
+    solver.setExact( threads );
+    solver.search();
+    auto solution = solver.getSolution();
+    if ( !isFeasible( instance, adjacency, solution ) ) {
+        return "infeasible exact solution";
+    }
+    if ( solution.size() != best ) {
+        return "exact solution of size " + std::to_string( solution.size() );
+    }
+    if ( !solver.isProvenOptimal() ) {
+        return "optimum not proven";
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> checkLowerBound( const Instance& instance, u32 best ) {
+    NuPDS solver;
+    solver.init( instance );
+    u32 bound = LowerBound( solver.pds_graph_ ).value();
+    if ( bound > best ) {
+        return "lower bound " + std::to_string( bound );
+    }
+    return std::nullopt;
+}
+
+// Random additions and removals, each followed by a comparison with a graph built from scratch
+std::optional<std::string> checkRemoval( const Instance& instance, Random& rng ) {
+    NuPDS solver;
+    solver.init( instance );
+    const PDSGraph base = solver.pds_graph_;
+    auto& graph = solver.pds_graph_;
+    std::vector<PDSGraph::Vertex> candidates( solver.add_available_vertices_.begin(),
+                                              solver.add_available_vertices_.end() );
+    std::vector<PDSGraph::Vertex> dominating;
+    for ( u32 step = 0; step < 50 && !candidates.empty(); step++ ) {
+        if ( !dominating.empty() && rng.nextBounded( 2 ) == 0 ) {
+            u32 i = rng.nextBounded( dominating.size() );
+            graph.removeDominating( dominating[i] );
+            dominating.erase( dominating.begin() + i );
+        } else {
+            auto v = candidates[rng.nextBounded( candidates.size() )];
+            if ( graph.isDominating( v ) ) {
+                continue;
+            }
+            graph.setDominating( v );
+            dominating.push_back( v );
+        }
+        PDSGraph fresh( base );
+        for ( auto v : dominating ) {
+            fresh.setDominating( v );
+        }
+        for ( auto v : graph.graph_.vertices() ) {
+            if ( fresh.isObserved( v ) != graph.isObserved( v ) ||
+                 fresh.unobservedDegree( v ) != graph.unobservedDegree( v ) ) {
+                return "removal differs from recompute at vertex " + std::to_string( v );
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+// Random updates and erasures, the queue has to list its items in the order of a sorted set of
+// (bucket, time of the last key change), and its minimum past a random item has to be the lowest
+// (key, age) of the others
+std::optional<std::string> checkBucketQueue( Random& rng ) {
+    u32 n = rng.nextInt( 1, 300 );
+    BucketQueue queue( n );
+    std::vector<std::optional<std::pair<u64, u64>>> entries( n );
+    std::vector<u64> ages( n );
+    std::set<std::tuple<u64, u64, u32>> reference;
+    u64 time = 0;
+    for ( u32 step = 0; step < 2000; step++ ) {
+        u32 item = rng.nextBounded( n );
+        if ( entries[item] ) {
+            auto [key, since] = *entries[item];
+            reference.erase( { BucketQueue::bucketOf( key ), since, item } );
+        }
+        if ( rng.nextBounded( 5 ) == 0 ) {
+            queue.erase( item );
+            entries[item].reset();
+        } else {
+            // Light keys get a bucket each, heavy ones share theirs; an unchanged key keeps its place
+            u64 key = rng.nextBounded( 2 ) == 0 ? rng.nextBounded( 64 )
+                                                : rng.next() >> rng.nextBounded( 64 );
+            if ( entries[item] && rng.nextBounded( 3 ) == 0 ) {
+                key = entries[item]->first;
+            }
+            u64 since = entries[item] && entries[item]->first == key ? entries[item]->second : ++time;
+            // Ages are distinct, so the minimum is unique
+            ages[item] = rng.nextBounded( 4 ) * n + item;
+            queue.update( item, key, ages[item] );
+            entries[item].emplace( key, since );
+            reference.emplace( BucketQueue::bucketOf( key ), since, item );
+        }
+        if ( step % 50 == 0 ) {
+            auto expected = reference.begin();
+            for ( auto v = queue.front(); v != BucketQueue::NONE;
+                  v = queue.successor( v ), expected++ ) {
+                if ( expected == reference.end() || std::get<2>( *expected ) != v ) {
+                    return "bucket queue out of order at step " + std::to_string( step );
+                }
+            }
+            if ( expected != reference.end() || queue.size() != reference.size() ) {
+                return "bucket queue lost items at step " + std::to_string( step );
+            }
+            u32 skip = rng.nextBounded( n );
+            auto best = BucketQueue::NONE;
+            for ( u32 v = 0; v < n; v++ ) {
+                if ( v != skip && entries[v] &&
+                     ( best == BucketQueue::NONE ||
+                       std::pair( entries[v]->first, ages[v] ) <
+                           std::pair( entries[best]->first, ages[best] ) ) ) {
+                    best = v;
+                }
+            }
+            if ( queue.min( skip ) != best ) {
+                return "bucket queue minimum wrong at step " + std::to_string( step );
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+// An edge list above the parallel threshold, with duplicates in both directions and self loops, has
+// to give the same adjacency on any number of threads as a sorted and deduplicated arc list
+std::optional<std::string> checkBulkBuild( Random& rng ) {
+    u32 n = 1 << 16;
+    std::vector<std::pair<u32, u32>> edges;
+    edges.reserve( Topology::PARALLEL_THRESHOLD + ( 1 << 16 ) );
+    while ( edges.size() < edges.capacity() ) {
+        u32 u = rng.nextBounded( n );
+        if ( !edges.empty() && rng.nextBounded( 8 ) == 0 ) {
+            auto [v, w] = edges[rng.nextBounded( edges.size() )];
+            rng.nextBounded( 2 ) == 0 ? edges.emplace_back( v, w ) : edges.emplace_back( w, v );
+        } else if ( rng.nextBounded( 16 ) == 0 ) {
+            edges.emplace_back( u, u );
+        } else {
+            edges.emplace_back( u, rng.nextBounded( n ) );
+        }
+    }
+
+    std::vector<std::pair<u32, u32>> arcs;
+    for ( auto [u, v] : edges ) {
+        if ( u != v ) {
+            arcs.emplace_back( u, v );
+            arcs.emplace_back( v, u );
+        }
+    }
+    std::sort( arcs.begin(), arcs.end() );
+    arcs.erase( std::unique( arcs.begin(), arcs.end() ), arcs.end() );
+    auto reference = Topology::fromEdges( n, edges, true, 1 );
+    if ( reference.numArcs() != arcs.size() ) {
+        return "bulk build kept " + std::to_string( reference.numArcs() ) + " arcs";
+    }
+    auto arc = arcs.begin();
+    for ( u32 v = 0; v < n; v++ ) {
+        for ( auto w : reference.neighbors( v ) ) {
+            if ( *arc++ != std::pair( v, w ) ) {
+                return "bulk build differs at vertex " + std::to_string( v );
+            }
+        }
+    }
+
+    for ( u32 threads : { 2, 8 } ) {
+        auto graph = Topology::fromEdges( n, edges, true, threads );
+        if ( !std::ranges::equal( graph.offsets(), reference.offsets() ) ||
+             !std::ranges::equal( graph.targets(), reference.targets() ) ) {
+            return "bulk build on " + std::to_string( threads ) + " threads differs";
+        }
+    }
+    return std::nullopt;
+}
+
+void print( const Instance& instance ) {
+    std::cout << instance.num_vertices << " " << instance.edges.size() << "\n";
+    for ( auto [u, v] : instance.edges ) {
+        std::cout << u << " " << v << "\n";
+    }
+    for ( auto* list : { &instance.insured, &instance.excluded, &instance.non_propagating } ) {
+        std::cout << list->size();
+        for ( auto v : *list ) {
+            std::cout << " " << v;
+        }
+        std::cout << "\n";
+    }
+}
+
+}  // namespace
+
+int main( int argc, const char* argv[] ) {
+    u32 instances = argc > 1 ? std::stoul( argv[1] ) : 500;
+    Random rng( argc > 2 ? std::stoull( argv[2] ) : 1 );
+
+    u32 failures = 0, solved = 0;
+    if ( auto error = checkBulkBuild( rng ) ) {
+        std::cout << "Failed: " << *error << "\n";
+        failures++;
+    }
+    for ( u32 i = 0; i < instances / 10 + 1; i++ ) {
+        for ( auto& error : { checkBucketQueue( rng ) } ) {
+            if ( error ) {
+                std::cout << "Failed: " << *error << "\n";
+                failures++;
+            }
+        }
+    }
+    for ( u32 i = 0; i < instances; i++ ) {
+        auto instance = randomInstance( rng, rng.nextInt( 3, 12 ), i % 2 == 1 );
+        std::vector<std::vector<u32>> adjacency( instance.num_vertices );
+        for ( auto [u, v] : instance.edges ) {
+            adjacency[u].push_back( v );
+            adjacency[v].push_back( u );
+        }
+
+        u32 best = optimum( instance, adjacency );
+        std::vector<std::optional<std::string>> errors;
+        errors.push_back( checkInit( instance, best != NONE ) );
+        if ( best != NONE ) {
+            solved++;
+            errors.push_back( checkRemoval( instance, rng ) );
+            errors.push_back( checkLowerBound( instance, best ) );
+            errors.push_back( checkExact( instance, adjacency, best, false, 1 ) );
+            errors.push_back( checkExact( instance, adjacency, best, true, 1 + i % 3 ) );
+        }
+        for ( auto& error : errors ) {
+            if ( error ) {
+                std::cout << "Failed: " << *error << " (optimum " << best << ")\n";
+                print( instance );
+                failures++;
+            }
+        }
+    }
+    std::cout << instances << " instances, " << solved << " feasible, " << failures << " failures"
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+#include "components.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "threadpool.hpp"
+
+Components::Components( const Instance& instance ) {
+    u32 n = instance.num_vertices;
+    auto check = [n]( u32 v ) {
+        if ( v >= n ) {
+            throw std::runtime_error( "vertex " + std::to_string( v ) + " out of range" );
+        }
+    };
+    for ( auto [u, v] : instance.edges ) {
+        check( u );
+        check( v );
+    }
+    for ( auto* list : { &instance.insured, &instance.excluded, &instance.non_propagating } ) {
+        for ( auto v : *list ) {
+            check( v );
+        }
+    }
+    std::vector<u32> parent( n );
+    std::iota( parent.begin(), parent.end(), 0 );
+    auto find = [&parent]( u32 v ) {
+        while ( parent[v] != v ) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+    for ( auto [u, v] : instance.edges ) {
+        auto ru = find( u ), rv = find( v );
+        if ( ru != rv ) {
+            parent[std::max( ru, rv )] = std::min( ru, rv );
+        }
+    }
+
+    std::vector<u32> roots;
+    for ( u32 v = 0; v < n; v++ ) {
+        if ( parent[v] == v ) {
+            roots.push_back( v );
+        }
+    }
+    count_ = roots.size();
+    // A connected instance is solved as it is, copying it would only cost time and memory
+    if ( count_ <= 1 ) {
+        return;
+    }
+
+    // Number the components by decreasing size and the vertices within each of them
+    constexpr u32 NONE = std::numeric_limits<u32>::max();
+    std::vector<u32> size( n, 0 );
+    for ( u32 v = 0; v < n; v++ ) {
+        size[find( v )]++;
+    }
+    std::stable_sort( roots.begin(), roots.end(),
+                      [&size]( u32 a, u32 b ) { return size[a] > size[b]; } );
+    std::vector<u32> index( n, NONE );
+    for ( u32 i = 0; i < roots.size(); i++ ) {
+        index[roots[i]] = i;
+    }
+    components_.resize( roots.size() );
+    ids_.resize( roots.size() );
+    std::vector<u32> local( n );
+    for ( u32 v = 0; v < n; v++ ) {
+        auto c = index[find( v )];
+        local[v] = components_[c].num_vertices++;
+        ids_[c].push_back( v );
+    }
+    for ( auto [u, v] : instance.edges ) {
+        components_[index[find( u )]].edges.emplace_back( local[u], local[v] );
+    }
+    auto distribute = [&]( const std::vector<u32>& list, std::vector<u32> Instance::*member ) {
+        for ( auto v : list ) {
+            ( components_[index[find( v )]].*member ).push_back( local[v] );
+        }
+    };
+    distribute( instance.insured, &Instance::insured );
+    distribute( instance.excluded, &Instance::excluded );
+    distribute( instance.non_propagating, &Instance::non_propagating );
+}
+
+std::vector<unsigned long> Components::solve( const NuPDS& prototype, u32 threads ) const {
+    using Clock = std::chrono::steady_clock;
+    auto deadline = Clock::now() + std::chrono::duration<double>( prototype.getCutoff() );
+    threads = std::max<u32>( threads, 1 );
+    // Vertices of the components from i on, which still have to share the time left
+    std::vector<double> pending( size() + 1, 0 );
+    for ( size_t i = size(); i-- > 0; ) {
+        pending[i] = pending[i + 1] + components_[i].num_vertices;
+    }
+
+    // Same streams as `split( i )`, which would jump i times for every component
+    std::vector<Random> streams;
+    streams.reserve( size() );
+    Random stream = prototype.getRandom();
+    for ( size_t i = 0; i < size(); i++ ) {
+        stream.jump();
+        streams.push_back( stream );
+    }
+
+    std::vector<std::vector<unsigned long>> solutions( size() );
+    std::atomic<size_t> next = 0;
+    // The first error of a worker, e.g. an infeasible component, stops the others and is rethrown
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool( threads );
+    pool.run( [&]( u32 ) {
+        for ( size_t i = next++; i < size(); i = next++ ) {
+            NuPDS solver( prototype );
+            solver.setRandom( streams[i] );
+            solver.setVerbose( false );
+            std::exception_ptr failure;
+            try {
+                solver.init( components_[i] );
+            } catch ( const std::runtime_error& e ) {
+                // Vertex ids in the message are local to the component
+                failure = std::make_exception_ptr( std::runtime_error(
+                    "component of input vertex " + std::to_string( ids_[i][0] ) + ": " + e.what() ) );
+            } catch ( ... ) {
+                failure = std::current_exception();
+            }
+            if ( failure ) {
+                std::lock_guard lock( error_mutex );
+                if ( !error ) {
+                    error = failure;
+                }
+                next = size();
+                break;
+            }
+            solver.preProcess();
+            // The components from i on run `threads` at a time in the time left, each gets a share
+            // proportional to its size; none runs past the deadline
+            double remaining = std::chrono::duration<double>( deadline - Clock::now() ).count();
+            double parallel = std::min<double>( threads, size() - i );
+            double share = remaining * parallel * components_[i].num_vertices / pending[i];
+            solver.setCutoff( std::max( 0.0, std::min( remaining, share ) ) );
+            solver.search();
+            for ( auto v : solver.getSolution() ) {
+                solutions[i].push_back( ids_[i][v] );
+            }
+        }
+    } );
+    if ( error ) {
+        std::rethrow_exception( error );
+    }
+
+    std::vector<unsigned long> solution;
+    for ( auto& part : solutions ) {
+        solution.insert( solution.end(), part.begin(), part.end() );
+    }
+    return solution;
+}
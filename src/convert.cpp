@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "basic.hpp"
+#include "graphfile.hpp"
+#include "instance.hpp"
+#include "loader.hpp"
+#include "pdsgraph.hpp"
+
+// Compiles a text instance into a graph file, see `GraphFile`. With --reorder, vertices are
+// renumbered in breadth-first order, which keeps neighborhoods close in memory; the original ids
+// are stored in the file and the solver reports solutions in them.
+int main( int argc, const char* argv[] ) {
+    if ( argc < 3 ) {
+        std::cerr << "usage: " << argv[0] << " <input> <output> [--reorder]" << std::endl;
+        return 1;
+    }
+    bool reorder = argc > 3 && std::string( argv[3] ) == "--reorder";
+
+    MappedFile input( argv[1] );
+    Scanner scanner( input.data() );
+    std::string title( scanner.word() );
+    auto instance = Instance::parse( scanner );
+    u32 n = instance.num_vertices;
+
+    for ( auto [u, v] : instance.edges ) {
+        if ( u >= n || v >= n ) {
+            std::cerr << "edge " << u << " " << v << " out of range" << std::endl;
+            return 1;
+        }
+    }
+    for ( auto* list : { &instance.insured, &instance.excluded, &instance.non_propagating } ) {
+        for ( auto v : *list ) {
+            if ( v >= n ) {
+                std::cerr << "vertex " << v << " out of range" << std::endl;
+                return 1;
+            }
+        }
+    }
+    auto topology = Topology::fromEdges( n, instance.edges );
+
+    // Breadth-first order, which also counts the components
+    std::vector<u32> order;
+    std::vector<u32> position( n, n );
+    u32 components = 0;
+    order.reserve( n );
+    for ( u32 root = 0; root < n; root++ ) {
+        if ( position[root] != n ) {
+            continue;
+        }
+        components++;
+        position[root] = order.size();
+        order.push_back( root );
+        for ( size_t i = position[root]; i < order.size(); i++ ) {
+            for ( auto w : topology.neighbors( order[i] ) ) {
+                if ( position[w] == n ) {
+                    position[w] = order.size();
+                    order.push_back( w );
+                }
+            }
+        }
+    }
+
+    std::vector<u32> ids;
+    if ( reorder ) {
+        std::vector<u32> offsets( n + 1, 0 );
+        std::vector<u32> targets;
+        targets.reserve( topology.numArcs() );
+        for ( u32 i = 0; i < n; i++ ) {
+            for ( auto w : topology.neighbors( order[i] ) ) {
+                targets.push_back( position[w] );
+            }
+            // Relabeling breaks the order of the list, which `GraphFile` requires
+            std::sort( targets.begin() + offsets[i], targets.end() );
+            offsets[i + 1] = targets.size();
+        }
+        topology = Topology( std::move( offsets ), std::move( targets ) );
+        ids = order;
+    } else {
+        for ( u32 v = 0; v < n; v++ ) {
+            position[v] = v;
+        }
+    }
+
+    std::vector<u8> flags;
+    auto mark = [&]( const std::vector<u32>& list, u8 flag ) {
+        for ( auto v : list ) {
+            flags.resize( n, 0 );
+            flags[position[v]] |= flag;
+        }
+    };
+    mark( instance.insured, GraphFile::INSURED );
+    mark( instance.excluded, GraphFile::EXCLUDED );
+    mark( instance.non_propagating, GraphFile::NON_PROPAGATING );
+
+    std::ofstream out( argv[2], std::ios::binary );
+    GraphFile::write( out, title, topology, components, flags, ids );
+    std::cout << n << " vertices, " << topology.numArcs() / 2 << " edges, " << components
+              << " components" << std::endl;
+    return 0;
+}
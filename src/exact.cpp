@@ -0,0 +1,208 @@
+#include "exact.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "threadpool.hpp"
+
+ExactSolver::ExactSolver( const PDSGraph& base, std::span<const Vertex> candidates,
+                          std::span<const Vertex> incumbent, u32 threads )
+    : best_size_( incumbent.size() ), best_solution_( incumbent.begin(), incumbent.end() ) {
+    for ( u32 i = 0; i < std::max<u32>( threads, 1 ); i++ ) {
+        workers_.push_back( std::make_unique<Worker>( base ) );
+    }
+    allowed_.assign( base.state_.size(), false );
+    for ( auto v : candidates ) {
+        allowed_[v] = true;
+    }
+    for ( auto v : base.graph_.vertices() ) {
+        insured_ += base.isInSured( v );
+    }
+}
+
+ExactSolver::Worker::Worker( const PDSGraph& base ) : graph( base ), position( base.state_.size() ) {
+    for ( auto v : base.graph_.vertices() ) {
+        if ( !base.isObserved( v ) ) {
+            position[v] = order.size();
+            order.push_back( v );
+        }
+    }
+    unobserved = order.size();
+}
+
+void ExactSolver::Worker::observe( std::span<const Vertex> vertices ) {
+    for ( auto v : vertices ) {
+        assert( position[v] < unobserved && order[position[v]] == v );
+        auto last = order[--unobserved];
+        std::swap( order[position[v]], order[unobserved] );
+        position[last] = position[v];
+        position[v] = unobserved;
+    }
+}
+
+bool ExactSolver::canBranch( const PDSGraph& graph, Vertex v ) const {
+    return allowed_[v] && ( graph.isBlack( v ) || graph.state( v ) == VertexState::Observed );
+}
+
+ExactSolver::Vertex ExactSolver::selectBranchVertex( const PDSGraph& graph,
+                                                     std::span<const Vertex> unobserved ) const {
+    // The unobserved vertex with the fewest candidates in N[x] is the most constrained one
+    Vertex constrained = NONE;
+    u32 fewest = std::numeric_limits<u32>::max();
+    auto gain = [&graph]( Vertex v ) { return graph.unobservedDegree( v ) + !graph.isObserved( v ); };
+    for ( auto x : unobserved ) {
+        u32 count = canBranch( graph, x );
+        for ( auto& w : graph.neighbors( x ) ) {
+            count += canBranch( graph, w );
+        }
+        if ( count > 0 && count < fewest ) {
+            fewest = count;
+            constrained = x;
+        }
+    }
+
+    // Every candidate is then observed with only observed neighbors, dominating one changes nothing
+    if ( constrained == NONE ) {
+        return NONE;
+    }
+    Vertex best = NONE;
+    auto consider = [&]( Vertex v ) {
+        if ( canBranch( graph, v ) && ( best == NONE || gain( v ) > gain( best ) ) ) {
+            best = v;
+        }
+    };
+    consider( constrained );
+    for ( auto& w : graph.neighbors( constrained ) ) {
+        consider( w );
+    }
+    return best;
+}
+
+void ExactSolver::moveTo( Worker& worker, const Node& node ) {
+    size_t common = 0;
+    while ( common < worker.path.size() && common < node.size() &&
+            worker.path[common] == node[common] ) {
+        common++;
+    }
+    while ( worker.path.size() > common ) {
+        worker.graph.rollback( worker.checkpoints.back() );
+        worker.unobserved = worker.counts.back();
+        worker.checkpoints.pop_back();
+        worker.counts.pop_back();
+        worker.path.pop_back();
+    }
+    for ( size_t i = common; i < node.size(); i++ ) {
+        worker.checkpoints.push_back( worker.graph.checkpoint() );
+        worker.counts.push_back( worker.unobserved );
+        worker.path.push_back( node[i] );
+        if ( node[i].dominate ) {
+            worker.observe( worker.graph.setDominating( node[i].vertex ) );
+        } else {
+            worker.graph.setExclude( node[i].vertex );
+        }
+    }
+}
+
+std::optional<ExactSolver::Node> ExactSolver::take( u32 id ) {
+    {
+        auto& own = *workers_[id];
+        std::lock_guard lock( own.mutex );
+        if ( !own.open.empty() ) {
+            auto node = std::move( own.open.back() );
+            own.open.pop_back();
+            return node;
+        }
+    }
+    for ( u32 i = 1; i < workers_.size(); i++ ) {
+        auto& victim = *workers_[( id + i ) % workers_.size()];
+        std::lock_guard lock( victim.mutex );
+        if ( !victim.open.empty() ) {
+            auto node = std::move( victim.open.front() );
+            victim.open.pop_front();
+            return node;
+        }
+    }
+    return std::nullopt;
+}
+
+void ExactSolver::offer( const PDSGraph& graph ) {
+    std::lock_guard lock( best_mutex_ );
+    u32 size = insured_ + graph.getDominatingCount();
+    if ( size < best_size_ ) {
+        best_size_ = size;
+        best_solution_.clear();
+        for ( auto v : graph.graph_.vertices() ) {
+            if ( graph.isDominating( v ) || graph.isInSured( v ) ) {
+                best_solution_.push_back( v );
+            }
+        }
+        if ( size <= lower_bound_ ) {
+            stop_ = true;
+        }
+    }
+}
+
+void ExactSolver::expand( u32 id, Node node ) {
+    auto& worker = *workers_[id];
+    moveTo( worker, node );
+    auto& graph = worker.graph;
+    u32 size = insured_ + graph.getDominatingCount();
+    if ( graph.allObserved() ) {
+        offer( graph );
+        return;
+    }
+    // Sorted, so that neither the bound nor the branching depends on the worker's history
+    worker.region.assign( worker.order.begin(), worker.order.begin() + worker.unobserved );
+    std::sort( worker.region.begin(), worker.region.end() );
+    auto residual = worker.bound.compute( graph, allowed_, worker.region );
+    if ( residual == ResidualBound::INFEASIBLE || size + residual >= best_size_ ) {
+        return;
+    }
+    auto v = selectBranchVertex( graph, worker.region );
+    if ( v == NONE ) {
+        return;
+    }
+    // Pushed in reverse, so the owner continues with dominating `v`
+    pending_ += 2;
+    std::lock_guard lock( worker.mutex );
+    node.push_back( { v, false } );
+    worker.open.push_back( node );
+    node.back().dominate = true;
+    worker.open.push_back( std::move( node ) );
+}
+
+bool ExactSolver::solve( double seconds ) {
+    using Clock = std::chrono::steady_clock;
+    deadline_ = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>( seconds ) );
+    if ( best_size_ <= lower_bound_ ) {
+        return true;
+    }
+    workers_[0]->open.push_back( {} );
+    pending_ = 1;
+
+    ThreadPool pool( workers_.size() );
+    pool.run( [this]( u32 id ) {
+        while ( !stop_ ) {
+            auto node = take( id );
+            if ( !node ) {
+                if ( pending_ == 0 ) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            // Every node scans its unobserved region, so the clock is read on each one
+            ++nodes_;
+            if ( Clock::now() >= deadline_ ) {
+                timed_out_ = true;
+                stop_ = true;
+                break;
+            }
+            expand( id, std::move( *node ) );
+            pending_--;
+        }
+    } );
+    return !timed_out_;
+}
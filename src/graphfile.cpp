@@ -0,0 +1,138 @@
+#include "graphfile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <stdexcept>
+
+namespace {
+constexpr size_t ALIGNMENT = 8;
+
+inline size_t padded( size_t bytes ) { return ( bytes + ALIGNMENT - 1 ) / ALIGNMENT * ALIGNMENT; }
+
+// Returns the section of `count` elements at `position` and moves `position` past it
+template <typename T>
+std::span<const T> section( std::string_view data, size_t& position, size_t count ) {
+    if ( position + count * sizeof( T ) > data.size() ) {
+        throw std::runtime_error( "truncated graph file" );
+    }
+    std::span<const T> result( reinterpret_cast<const T*>( data.data() + position ), count );
+    position += padded( count * sizeof( T ) );
+    return result;
+}
+}  // namespace
+
+bool GraphFile::matches( std::string_view data ) {
+    return data.size() >= sizeof( MAGIC ) && std::memcmp( data.data(), MAGIC, sizeof( MAGIC ) ) == 0;
+}
+
+GraphFile::GraphFile( std::string_view data ) {
+    if ( !matches( data ) || data.size() < sizeof( Header ) ) {
+        throw std::runtime_error( "not a compiled graph file" );
+    }
+    std::memcpy( &header_, data.data(), sizeof( Header ) );
+    if ( header_.version != VERSION ) {
+        throw std::runtime_error( "unsupported graph file version " +
+                                  std::to_string( header_.version ) );
+    }
+
+    // Offsets and targets are 32 bit
+    if ( header_.num_vertices >= std::numeric_limits<u32>::max() ||
+         header_.num_arcs > std::numeric_limits<u32>::max() ) {
+        throw std::runtime_error( "graph file too large" );
+    }
+
+    size_t position = padded( sizeof( Header ) );
+    auto title = section<char>( data, position, header_.title_length );
+    title_ = { title.data(), title.size() };
+    offsets_ = section<u32>( data, position, header_.num_vertices + 1 );
+    targets_ = section<u32>( data, position, header_.num_arcs );
+    if ( header_.sections & HAS_FLAGS ) {
+        flags_ = section<u8>( data, position, header_.num_vertices );
+    }
+    if ( header_.sections & HAS_IDS ) {
+        ids_ = section<u32>( data, position, header_.num_vertices );
+    }
+    // The topology is used without further checks, so validate it in one sequential pass
+    if ( offsets_.front() != 0 || offsets_.back() != targets_.size() ) {
+        throw std::runtime_error( "corrupt graph file offsets" );
+    }
+    u32 n = numVertices();
+    for ( u32 v = 0; v < n; v++ ) {
+        if ( offsets_[v + 1] < offsets_[v] ) {
+            throw std::runtime_error( "corrupt graph file offsets" );
+        }
+        for ( auto i = offsets_[v]; i < offsets_[v + 1]; i++ ) {
+            if ( targets_[i] >= n ) {
+                throw std::runtime_error( "corrupt graph file targets" );
+            }
+        }
+    }
+    // Every list strictly increasing without `v` itself, and every arc has its reverse arc. The
+    // first pass bounds every offset, so the lists can be searched here
+    for ( u32 v = 0; v < n; v++ ) {
+        for ( auto i = offsets_[v]; i < offsets_[v + 1]; i++ ) {
+            auto w = targets_[i];
+            if ( w == v || ( i > offsets_[v] && targets_[i - 1] >= w ) ) {
+                throw std::runtime_error( "corrupt graph file adjacency" );
+            }
+            auto reverse = targets_.subspan( offsets_[w], offsets_[w + 1] - offsets_[w] );
+            if ( !std::binary_search( reverse.begin(), reverse.end(), v ) ) {
+                throw std::runtime_error( "corrupt graph file adjacency" );
+            }
+        }
+    }
+}
+
+Instance GraphFile::toInstance() const {
+    Instance instance;
+    instance.num_vertices = numVertices();
+    instance.edges.reserve( targets_.size() / 2 );
+    for ( u32 v = 0; v < numVertices(); v++ ) {
+        for ( auto i = offsets_[v]; i < offsets_[v + 1]; i++ ) {
+            if ( v < targets_[i] ) {
+                instance.edges.emplace_back( v, targets_[i] );
+            }
+        }
+    }
+    for ( u32 v = 0; v < flags_.size(); v++ ) {
+        if ( flags_[v] & INSURED ) {
+            instance.insured.push_back( v );
+        }
+        if ( flags_[v] & EXCLUDED ) {
+            instance.excluded.push_back( v );
+        }
+        if ( flags_[v] & NON_PROPAGATING ) {
+            instance.non_propagating.push_back( v );
+        }
+    }
+    return instance;
+}
+
+void GraphFile::write( std::ostream& out, std::string_view title, const Topology& topology,
+                       u32 components, std::span<const u8> flags, std::span<const u32> ids ) {
+    Header header{};
+    std::memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+    header.version = VERSION;
+    header.sections = ( flags.empty() ? 0 : HAS_FLAGS ) | ( ids.empty() ? 0 : HAS_IDS );
+    header.num_vertices = topology.numVertices();
+    header.num_arcs = topology.numArcs();
+    header.num_components = components;
+    header.title_length = title.size();
+
+    auto put = [&out]( const void* data, size_t bytes ) {
+        static constexpr char ZEROS[ALIGNMENT] = {};
+        out.write( static_cast<const char*>( data ), bytes );
+        out.write( ZEROS, padded( bytes ) - bytes );
+    };
+    put( &header, sizeof( header ) );
+    put( title.data(), title.size() );
+    put( topology.offsets().data(), topology.offsets().size_bytes() );
+    put( topology.targets().data(), topology.targets().size_bytes() );
+    put( flags.data(), flags.size_bytes() );
+    put( ids.data(), ids.size_bytes() );
+    if ( !out ) {
+        throw std::runtime_error( "cannot write graph file" );
+    }
+}
@@ -0,0 +1,40 @@
+#include "loader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+
+MappedFile::MappedFile( const std::string& path ) {
+    int fd = open( path.c_str(), O_RDONLY );
+    if ( fd < 0 ) {
+        throw std::runtime_error( "cannot open " + path );
+    }
+    struct stat info;
+    if ( fstat( fd, &info ) == 0 && S_ISREG( info.st_mode ) && info.st_size > 0 ) {
+        void* address = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( address != MAP_FAILED ) {
+            // The parser makes one forward pass
+            madvise( address, info.st_size, MADV_SEQUENTIAL );
+            data_ = static_cast<const char*>( address );
+            size_ = info.st_size;
+            mapped_ = true;
+        }
+    }
+    close( fd );
+    if ( !mapped_ ) {
+        std::ifstream in( path, std::ios::binary );
+        buffer_.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+    }
+}
+
+MappedFile::~MappedFile() {
+    if ( mapped_ ) {
+        munmap( const_cast<char*>( data_ ), size_ );
+    }
+}
@@ -0,0 +1,172 @@
+#include "lowerbound.hpp"
+
+#include <algorithm>
+
+LowerBound::LowerBound( const PDSGraph& graph ) {
+    auto n = graph.state_.size();
+    legs_.assign( n, 0 );
+    attach_.assign( n, NONE );
+    component_.assign( n, NONE );
+    auto degree = [&graph]( Vertex v ) { return graph.neighbors( v ).size(); };
+
+    // Walk every pendant path from its leaf up to the first vertex of degree three or more
+    std::vector<Vertex> leg;
+    for ( auto leaf : graph.graph_.vertices() ) {
+        if ( degree( leaf ) != 1 ) {
+            continue;
+        }
+        leg.assign( 1, leaf );
+        Vertex current = graph.neighbors( leaf )[0];
+        while ( degree( current ) == 2 ) {
+            auto next = graph.neighbors( current );
+            Vertex previous = leg.back();
+            leg.push_back( current );
+            current = next[0] == previous ? next[1] : next[0];
+        }
+        // A path component has no attachment, its leaves only meet each other
+        if ( degree( current ) < 3 ) {
+            continue;
+        }
+        legs_[current]++;
+        for ( auto v : leg ) {
+            attach_[v] = current;
+        }
+    }
+
+    // Per component: spiders, plus insured vertices which are not part of one
+    std::vector<Vertex> queue;
+    for ( auto root : graph.graph_.vertices() ) {
+        if ( component_[root] != NONE ) {
+            continue;
+        }
+        u32 count = 0;
+        component_[root] = components_;
+        queue.assign( 1, root );
+        for ( size_t i = 0; i < queue.size(); i++ ) {
+            auto v = queue[i];
+            if ( legs_[v] >= 2 ) {
+                count++;
+                spiders_++;
+            }
+            for ( auto w : graph.neighbors( v ) ) {
+                if ( component_[w] == NONE ) {
+                    component_[w] = components_;
+                    queue.push_back( w );
+                }
+            }
+        }
+        for ( auto v : queue ) {
+            Vertex spider = legs_[v] >= 2 ? v : attach_[v];
+            if ( graph.isInSured( v ) && ( spider == NONE || legs_[spider] < 2 ) ) {
+                count++;
+            }
+        }
+        value_ += std::max<u32>( count, 1 );
+        components_++;
+    }
+}
+
+bool ResidualBound::grow( const PDSGraph& graph, Vertex seed ) {
+    fort_id_++;
+    fort_.clear();
+    pending_.clear();
+    auto add = [&]( Vertex z ) {
+        if ( tried_[z] == call_ ) {
+            return false;
+        }
+        tried_[z] = call_;
+        member_[z] = fort_id_;
+        fort_.push_back( z );
+        for ( auto y : graph.neighbors( z ) ) {
+            if ( member_[y] == fort_id_ ) {
+                continue;
+            }
+            if ( touched_[y] != fort_id_ ) {
+                touched_[y] = fort_id_;
+                count_[y] = 0;
+            }
+            if ( ++count_[y] == 1 ) {
+                pending_.push_back( y );
+            }
+        }
+        return true;
+    };
+    if ( !add( seed ) ) {
+        return false;
+    }
+    while ( !pending_.empty() ) {
+        auto y = pending_.back();
+        pending_.pop_back();
+        if ( member_[y] == fort_id_ || count_[y] != 1 || graph.isNonPropagating( y ) ) {
+            continue;
+        }
+        // `y` could force its only neighbor in the fort: take `y` itself or give it a second one,
+        // whichever has the fewest unobserved neighbors to keep the fort small
+        Vertex pick = graph.isObserved( y ) ? NONE : y;
+        for ( auto w : graph.neighbors( y ) ) {
+            if ( !graph.isObserved( w ) && member_[w] != fort_id_ &&
+                 ( pick == NONE || graph.unobservedDegree( w ) < graph.unobservedDegree( pick ) ) ) {
+                pick = w;
+            }
+        }
+        if ( pick == NONE || !add( pick ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u32 ResidualBound::compute( const PDSGraph& graph, std::span<const u8> allowed,
+                            std::span<const Vertex> unobserved ) {
+    auto n = graph.state_.size();
+    if ( tried_.size() < n ) {
+        tried_.resize( n, 0 );
+        used_.resize( n, 0 );
+        member_.resize( n, 0 );
+        touched_.resize( n, 0 );
+        count_.resize( n, 0 );
+    }
+    call_++;
+    auto isCandidate = [&]( Vertex v ) {
+        return allowed[v] && ( graph.isBlack( v ) || graph.state( v ) == VertexState::Observed );
+    };
+
+    u32 count = 0;
+    for ( bool leaves : { true, false } ) {
+        for ( auto x : unobserved ) {
+            if ( tried_[x] == call_ || ( leaves && graph.unobservedDegree( x ) > 1 ) ) {
+                continue;
+            }
+            if ( !grow( graph, x ) ) {
+                continue;
+            }
+            bool candidate = false, disjoint = true;
+            auto check = [&]( Vertex v ) {
+                if ( isCandidate( v ) ) {
+                    candidate = true;
+                    disjoint = disjoint && used_[v] != call_;
+                }
+            };
+            for ( auto z : fort_ ) {
+                check( z );
+                for ( auto w : graph.neighbors( z ) ) {
+                    check( w );
+                }
+            }
+            if ( !candidate ) {
+                return INFEASIBLE;
+            }
+            if ( !disjoint ) {
+                continue;
+            }
+            count++;
+            for ( auto z : fort_ ) {
+                used_[z] = call_;
+                for ( auto w : graph.neighbors( z ) ) {
+                    used_[w] = call_;
+                }
+            }
+        }
+    }
+    return unobserved.empty() ? 0 : std::max<u32>( count, 1 );
+}
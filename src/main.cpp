@@ -1,9 +1,17 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <string>
+#include <thread>
 
+#include "components.hpp"
+#include "graphfile.hpp"
+#include "instance.hpp"
+#include "loader.hpp"
 #include "nupds.hpp"
+#include "portfolio.hpp"
 
 auto now() { return std::chrono::high_resolution_clock::now(); }
 
@@ -12,20 +20,101 @@ int main( int argc, const char *argv[] ) {
         exit( 1 );
     }
 
-    std::ifstream fin( argv[1] );
+    // Compiled instances are used in place, text is parsed into an instance
+    MappedFile input( argv[1] );
+    std::optional<GraphFile> compiled;
+    Instance instance;
+    std::string t;
+    if ( GraphFile::matches( input.data() ) ) {
+        compiled.emplace( input.data() );
+        t = compiled->title();
+        // Only the split into components needs an edge list
+        if ( compiled->numComponents() > 1 ) {
+            instance = compiled->toInstance();
+        }
+    } else {
+        Scanner scanner( input.data() );
+        t = scanner.word();
+        instance = Instance::parse( scanner );
+    }
     std::ofstream fout( argv[2] );
 
     NuPDS solver;
+    if ( argc > 3 ) {
+        solver.setCutoff( std::stod( argv[3] ) );
+    }
 
-    std::string t;
-    fin >> t;
+    u32 threads = 1;
+    if ( argc > 4 ) {
+        threads = std::stoul( argv[4] );
+        if ( threads == 0 ) {
+            threads = std::thread::hardware_concurrency();
+        }
+    }
 
-    solver.init( fin );
-    // pds.pre_process();
+    if ( argc > 6 ) {
+        solver.setSeed( std::stoull( argv[6] ) );
+    } else {
+        solver.setSeed( std::random_device{}() );
+    }
+    if ( argc > 7 ) {
+        solver.setLazyGreedy( std::stoul( argv[7] ) != 0 );
+    }
+    bool exact = argc > 8 && std::stoul( argv[8] ) != 0;
+    if ( argc > 9 ) {
+        // Swap moves take the first improving entry (0) or the best one (1)
+        solver.setSwapPolicy( std::stoul( argv[9] ) != 0 ? MoveEngine::Policy::BestImprovement
+                                                         : MoveEngine::Policy::FirstImprovement );
+    }
 
-    auto t0 = now();
+    // Loading and preprocessing are not timed, except per component where `solve` does them
+    decltype( now() ) t0;
+    std::vector<unsigned long> solution;
+    std::optional<Components> components;
+    if ( !compiled || compiled->numComponents() > 1 ) {
+        components.emplace( instance );
+    }
+    if ( components && components->size() > 1 ) {
+        // Disconnected inputs are solved per component, the threads work on different components
+        if ( argc > 5 ) {
+            solver.setEvaluationThreads( std::stoul( argv[5] ) );
+        }
+        if ( exact ) {
+            solver.setExact( 1 );
+        }
+        t0 = now();
+        solution = components->solve( solver, threads );
+    } else {
+        if ( compiled ) {
+            solver.init( *compiled );
+        } else {
+            solver.init( instance );
+        }
+        solver.preProcess();
+        if ( argc > 5 ) {
+            solver.setEvaluationThreads( std::stoul( argv[5] ) );
+        }
+        t0 = now();
+        if ( exact ) {
+            // The branch and bound spreads over the threads itself
+            solver.setExact( threads );
+            solver.search();
+            solution = solver.getSolution();
+        } else if ( threads > 1 ) {
+            Portfolio portfolio( solver, threads );
+            portfolio.search();
+            solution = portfolio.getSolution();
+        } else {
+            solver.search();
+            solution = solver.getSolution();
+        }
+    }
 
-    solver.search();
+    if ( compiled ) {
+        for ( auto &v : solution ) {
+            v = compiled->originalId( v );
+        }
+    }
 
     auto t1 = now();
 
@@ -34,8 +123,6 @@ int main( int argc, const char *argv[] ) {
     fout << std::chrono::duration_cast<std::chrono::microseconds>( t1 - t0 ).count() << "us"
          << std::endl;
 
-    auto solution = solver.getSolution();
-
     // auto solution = pds.get_best_solution();
     fout << solution.size() << std::endl;
     for ( auto &v : solution ) {
@@ -0,0 +1,131 @@
+#include "moves.hpp"
+
+void MoveEngine::collectEntries( const PDSGraph& graph, Vertex out, Vertex out2 ) {
+    // Only vertices in N[region] can observe a lost vertex directly
+    entries_.clear();
+    seen_.clear();
+    auto visit = [&]( Vertex v ) {
+        if ( v != out && v != out2 && !seen_.contains( v ) && canEnter( graph, v ) ) {
+            seen_.insert( v );
+            entries_.push_back( v );
+        }
+    };
+    for ( auto v : region_ ) {
+        visit( v );
+        for ( auto& w : graph.neighbors( v ) ) {
+            visit( w );
+        }
+    }
+}
+
+void MoveEngine::collectPartners( const PDSGraph& graph, Vertex out ) {
+    partners_.clear();
+    seen_.clear();
+    auto visit = [&]( Vertex v ) {
+        if ( v != out && !seen_.contains( v ) && graph.isDominating( v ) ) {
+            seen_.insert( v );
+            partners_.push_back( v );
+        }
+    };
+    for ( auto v : region_ ) {
+        for ( auto& w : graph.neighbors( v ) ) {
+            visit( w );
+            for ( auto& x : graph.neighbors( w ) ) {
+                visit( x );
+            }
+        }
+    }
+}
+
+std::optional<MoveEngine::Move> MoveEngine::bestEntry( PDSGraph& graph, Move move, u32 before,
+                                                       i64 threshold, Policy policy ) {
+    std::optional<Move> best;
+    for ( auto v : entries_ ) {
+        auto cp = graph.checkpoint();
+        graph.setDominating( v );
+        i64 delta = static_cast<i64>( graph.numObserved() ) - before;
+        graph.rollback( cp );
+        if ( delta >= threshold && ( !best || delta > best->delta ) ) {
+            move.in = v;
+            move.delta = delta;
+            best = move;
+            if ( policy == Policy::FirstImprovement ) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+std::optional<MoveEngine::Move> MoveEngine::findSwap( PDSGraph& graph, Vertex out, Policy policy,
+                                                      const VertexMap<u32>& weight,
+                                                      const EntryFilter& allowed ) {
+    auto cp = graph.checkpoint();
+    auto lost = graph.removeDominating( out );
+    i64 loss = 0;
+    for ( auto w : lost ) {
+        loss += weight.at( w );
+    }
+    region_.assign( lost.begin(), lost.end() );
+    collectEntries( graph, out, NONE );
+
+    std::optional<Move> best;
+    for ( auto v : entries_ ) {
+        if ( !allowed( v ) ) {
+            continue;
+        }
+        auto inner = graph.checkpoint();
+        i64 gain = 0;
+        for ( auto w : graph.setDominating( v ) ) {
+            gain += weight.at( w );
+        }
+        graph.rollback( inner );
+        if ( gain > loss && ( !best || gain - loss > best->delta ) ) {
+            best = Move{ .in = v, .out = out, .delta = gain - loss };
+            if ( policy == Policy::FirstImprovement ) {
+                break;
+            }
+        }
+    }
+    graph.rollback( cp );
+    return best;
+}
+
+std::optional<MoveEngine::Move> MoveEngine::findTwoForOne( PDSGraph& graph, Vertex out,
+                                                           Policy policy ) {
+    u32 before = graph.numObserved();
+    auto cp = graph.checkpoint();
+    auto lost = graph.removeDominating( out );
+    if ( lost.empty() ) {
+        graph.rollback( cp );
+        return Move{ .out = out };
+    }
+    if ( lost.size() > MAX_REGION ) {
+        graph.rollback( cp );
+        return std::nullopt;
+    }
+    region_.assign( lost.begin(), lost.end() );
+    collectPartners( graph, out );
+    size_t first_lost = region_.size();
+
+    std::optional<Move> best;
+    for ( size_t i = 0; i < partners_.size(); i++ ) {
+        auto partner = partners_[i];
+        auto inner = graph.checkpoint();
+        // Removing more vertices never observes a lost one again, so the region only grows
+        auto lost2 = graph.removeDominating( partner );
+        region_.insert( region_.end(), lost2.begin(), lost2.end() );
+        collectEntries( graph, out, partner );
+        auto move = bestEntry( graph, Move{ .out = out, .out2 = partner }, before, 0, policy );
+        graph.rollback( inner );
+        region_.resize( first_lost );
+        if ( move && ( !best || move->delta > best->delta ) ) {
+            best = move;
+            if ( policy == Policy::FirstImprovement ) {
+                break;
+            }
+        }
+    }
+    graph.rollback( cp );
+    return best;
+}
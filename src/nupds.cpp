@@ -1,132 +1,603 @@
 #include "nupds.hpp"
 
+#include <atomic>
 #include <cassert>
 #include <exception>
 #include <iostream>
 #include <iterator>
 #include <optional>
 #include <range/v3/range/conversion.hpp>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "basic.hpp"
+#include "exact.hpp"
+#include "lowerbound.hpp"
 #include "pdsgraph.hpp"
+#include "portfolio.hpp"
 #include "utility.hpp"
 
-static std::random_device rd{ "hw" };
-
-double random_alpha() {
-    static auto gen =
-        std::bind( std::uniform_real_distribution<>( 0, 1 ), std::default_random_engine( rd() ) );
-    return gen();
+std::pair<PDSGraph::Vertex, double> NuPDS::selectVertexToAdd( bool first ) {
+    if ( add_available_vertices_.empty() ) {
+        return { NONE, 0 };
+    }
+    if ( first ) {
+        lazy_heap_ = {};
+        return { add_available_vertices_[rng_.nextBounded( add_available_vertices_.size() )], 0 };
+    }
+    if ( lazy_greedy_ ) {
+        return getLazyMaxObserved();
+    }
+    return getMaxObserved();
 }
 
-u32 random_int( u32 l, u32 r ) {
-    static auto gen =
-        std::bind( std::uniform_int_distribution<u32>( l, r ), std::default_random_engine( rd() ) );
-    return gen();
+void NuPDS::seedLazyHeap() {
+    stale_.clear();
+    for ( auto& v : frontier_ ) {
+        if ( pds_graph_.isUpdate( v ) && add_available_vertices_.contains( v ) ) {
+            stale_.push_back( v );
+        }
+    }
+    if ( pool_ && stale_.size() >= PARALLEL_THRESHOLD ) {
+        evaluateInParallel( stale_ );
+    }
+    for ( auto& v : frontier_ ) {
+        if ( !add_available_vertices_.contains( v ) ) {
+            continue;
+        }
+        if ( pds_graph_.isUpdate( v ) ) {
+            score_cache_[v] = testAddVertex( pds_graph_, v );
+            pds_graph_.clearUpdate( v );
+        }
+        lazy_factor_[v] = 1 + perturbation_ * rng_.nextDouble();
+        lazy_heap_.emplace( lazy_factor_[v] * score_cache_[v], v );
+    }
 }
 
-std::pair<PDSGraph::Vertex, double> NuPDS::selectVertexToAdd( bool first ) {
-    if ( first ) {
-        mpgraphs::set<PDSGraph::Vertex>::const_iterator it = add_available_vertices_.begin();
-        std::advance( it, random_int( 0, add_available_vertices_.size() ) );
-        return { *it, 0 };
+std::pair<PDSGraph::Vertex, double> NuPDS::getLazyMaxObserved() {
+    // Propagation makes the score neither monotone nor submodular, so a stale key is not a true
+    // upper bound: this trades exactness of the greedy choice for far fewer trial propagations
+    if ( lazy_heap_.empty() ) {
+        seedLazyHeap();
+    }
+    while ( !lazy_heap_.empty() ) {
+        auto [key, v] = lazy_heap_.top();
+        lazy_heap_.pop();
+        if ( !add_available_vertices_.contains( v ) || !frontier_.contains( v ) ) {
+            continue;
+        }
+        if ( pds_graph_.isUpdate( v ) ) {
+            score_cache_[v] = testAddVertex( pds_graph_, v );
+            pds_graph_.clearUpdate( v );
+            lazy_heap_.emplace( lazy_factor_[v] * score_cache_[v], v );
+            continue;
+        }
+        // Entries superseded by a re-simulation are dropped, the current one is still queued
+        if ( key != lazy_factor_[v] * score_cache_[v] ) {
+            continue;
+        }
+        // Cached scores are approximate, see `invalidateScores`; a stale one is queued again
+        auto observed = testAddVertex( pds_graph_, v );
+        if ( observed != score_cache_[v] ) {
+            score_cache_[v] = observed;
+            lazy_heap_.emplace( lazy_factor_[v] * observed, v );
+            continue;
+        }
+        return { v, key };
     }
     return getMaxObserved();
 }
 
 std::pair<PDSGraph::Vertex, double> NuPDS::getMaxObserved() {
-    double maxn = 0;
-    PDSGraph::Vertex best = *add_available_vertices_.begin();
-    for ( auto& v : add_available_vertices_ ) {
-        if ( pds_graph_.graph_[v].update ) {
-            auto newly_observed = testAddVertex( pds_graph_, v );
-            auto score = ( 1 + random_alpha() ) * newly_observed.size();
+    if ( add_available_vertices_.empty() ) {
+        return { NONE, 0 };
+    }
+    if ( pool_ ) {
+        stale_.clear();
+        for ( auto& v : frontier_ ) {
+            if ( pds_graph_.isUpdate( v ) && add_available_vertices_.contains( v ) ) {
+                stale_.push_back( v );
+            }
+        }
+        if ( stale_.size() >= PARALLEL_THRESHOLD ) {
+            evaluateInParallel( stale_ );
+        }
+    }
+    // The perturbation is drawn in frontier order, so results do not depend on the thread count
+    drawn_.clear();
+    for ( auto& v : frontier_ ) {
+        if ( !add_available_vertices_.contains( v ) ) {
+            continue;
+        }
+        if ( pds_graph_.isUpdate( v ) ) {
+            score_cache_[v] = testAddVertex( pds_graph_, v );
+            pds_graph_.clearUpdate( v );
+        }
+        drawn_.emplace_back( 1 + perturbation_ * rng_.nextDouble(), v );
+    }
+    // Cached scores are approximate, see `invalidateScores`. The best vertex is re-evaluated and the
+    // choice is repeated with the same factors until its score is current
+    while ( true ) {
+        double maxn = 0;
+        PDSGraph::Vertex best = *add_available_vertices_.begin();
+        for ( auto [factor, v] : drawn_ ) {
+            auto score = factor * score_cache_[v];
             if ( score > maxn ) {
                 maxn = score;
                 best = v;
             }
         }
+        if ( maxn == 0 ) {
+            return { best, maxn };
+        }
+        auto observed = testAddVertex( pds_graph_, best );
+        if ( observed == score_cache_[best] ) {
+            return { best, maxn };
+        }
+        score_cache_[best] = observed;
     }
-    return { best, maxn };
 }
 
-std::vector<PDSGraph::Vertex> NuPDS::testAddVertex( PDSGraph graph, PDSGraph::Vertex v ) {
-    return graph.setDominating( v ) | ranges::to<std::vector<PDSGraph::Vertex>>();
+u32 NuPDS::testAddVertex( PDSGraph& graph, PDSGraph::Vertex v ) {
+    auto cp = graph.checkpoint();
+    u32 observed = graph.setDominating( v ).size();
+    graph.rollback( cp );
+    return observed;
 }
 
-// std::pair<NuPDS::Vertex, double> NuPDS::selectVertexToRemove() {
-//     auto [v, minn] = *remove_available_vertices_.begin();
-//     for ( auto& [w, score] : remove_available_vertices_ ) {
-//         if ( score < minn ) {
-//             minn = score;
-//             v = w;
-//         }
-//     }
-//     return { v, minn };
-// }
+void NuPDS::evaluateInParallel( std::vector<PDSGraph::Vertex>& candidates ) {
+    runOnReplicas( candidates.size(), [&]( PDSGraph& graph, size_t i ) {
+        score_cache_.at( candidates[i] ) = testAddVertex( graph, candidates[i] );
+    } );
+    for ( auto v : candidates ) {
+        pds_graph_.clearUpdate( v );
+    }
+}
+
+void NuPDS::runOnReplicas( size_t count, const std::function<void( PDSGraph&, size_t )>& task ) {
+    constexpr size_t CHUNK = 64;
+    std::atomic<size_t> next = 0;
+    refreshReplicas();
+    pool_->run( [&]( u32 id ) {
+        // Thread 0 is the caller and works on the solver's own graph, the others on replicas
+        PDSGraph& graph = id == 0 ? pds_graph_ : scratch_[id - 1];
+        if ( id > 0 ) {
+            syncReplica( graph );
+        }
+        for ( size_t begin = next.fetch_add( CHUNK ); begin < count; begin = next.fetch_add( CHUNK ) ) {
+            for ( size_t i = begin; i < std::min( begin + CHUNK, count ); i++ ) {
+                task( graph, i );
+            }
+        }
+    } );
+    pending_moves_.clear();
+}
 
-// // TODO This function has some optimization(check it out later)
-// std::pair<NuPDS::Vertex, double> NuPDS::getBestObserver() {
-//     double maxn = 0;
-//     Vertex best = *add_available_vertices_.begin();
+void NuPDS::syncReplica( PDSGraph& graph ) const {
+    for ( auto [v, add] : pending_moves_ ) {
+        if ( add ) {
+            graph.setDominating( v );
+        } else {
+            graph.removeDominating( v );
+        }
+    }
+}
 
-//     for ( auto v : add_available_vertices_ ) {
-//         auto prev_graph = graph_;
-//         auto prev_deps = dependencies_;
-//         auto prev_dominating_count = dominating_count_;
-//         auto prev_unobserved_degree = unobserved_degree_;
+bool NuPDS::isRemovable( PDSGraph& graph, PDSGraph::Vertex v ) {
+    // `removeDominating` only revisits the region observed through `v`
+    auto cp = graph.checkpoint();
+    bool removable = graph.removeDominating( v ).empty();
+    graph.rollback( cp );
+    return removable;
+}
 
-//         auto newlyObserved = setDominating( v );
-//         auto score = ( 1 + random_alpha() ) * newlyObserved.size();
-//         if ( score > maxn ) {
-//             maxn = score;
-//             best = v;
-//         }
+void NuPDS::filterRemovable( std::vector<PDSGraph::Vertex>& candidates ) {
+    removable_.assign( candidates.size(), false );
+    if ( pool_ && candidates.size() >= PARALLEL_THRESHOLD ) {
+        runOnReplicas( candidates.size(), [&]( PDSGraph& graph, size_t i ) {
+            removable_[i] = isRemovable( graph, candidates[i] );
+        } );
+    } else {
+        for ( size_t i = 0; i < candidates.size(); i++ ) {
+            removable_[i] = isRemovable( pds_graph_, candidates[i] );
+        }
+    }
+    size_t kept = 0;
+    for ( size_t i = 0; i < candidates.size(); i++ ) {
+        if ( removable_[i] ) {
+            candidates[kept++] = candidates[i];
+        }
+    }
+    candidates.resize( kept );
+}
 
-//         graph_ = std::move( prev_graph );
-//         dependencies_ = std::move( prev_deps );
-//         dominating_count_ = prev_dominating_count;
-//         unobserved_degree_ = std::move( prev_unobserved_degree );
-//     }
+u32 NuPDS::applySwaps() {
+    // 2-1 swaps shrink the solution without observing less; passes repeat until one finds nothing
+    u32 applied = 0;
+    bool improved = true;
+    while ( improved && !timeout() ) {
+        improved = false;
+        refreshLosses();
+        swap_order_.clear();
+        for ( auto v = remove_queue_.front(); v != BucketQueue::NONE;
+              v = remove_queue_.successor( v ) ) {
+            swap_order_.push_back( v );
+        }
+        for ( auto v : swap_order_ ) {
+            if ( timeout() ) {
+                break;
+            }
+            if ( !remove_available_vertices_.contains( v ) ) {
+                continue;
+            }
+            auto move = moves_.findTwoForOne( pds_graph_, v, swap_policy_ );
+            if ( !move || !isAllowed( *move ) ) {
+                continue;
+            }
+            applyMove( *move );
+            applied++;
+            improved = true;
+        }
+    }
+    return applied;
+}
 
-//     return { best, maxn };
-// }
+bool NuPDS::isAllowed( const MoveEngine::Move& move ) const {
+    // The engine knows the vertex states only, not what the reduction fixed
+    return ( move.out2 == MoveEngine::NONE || remove_available_vertices_.contains( move.out2 ) ) &&
+           ( move.in == MoveEngine::NONE || add_available_vertices_.contains( move.in ) );
+}
 
-void NuPDS::getClouser( PDSGraph::Vertex vertex, mpgraphs::set<PDSGraph::Vertex>& clouser,
-                        mpgraphs::set<PDSGraph::Vertex>& newly_observed ) {
-    for ( auto& v : newly_observed ) {
-        clouser.insert( v );
-        for ( auto& w : pds_graph_.graph_.neighbors( v ) ) {
-            if ( !clouser.contains( w ) ) {
-                clouser.insert( w );
+void NuPDS::applyMove( const MoveEngine::Move& move ) {
+    removeFromSolution( move.out );
+    if ( move.out2 != MoveEngine::NONE ) {
+        removeFromSolution( move.out2 );
+    }
+    if ( move.in != MoveEngine::NONE ) {
+        addToSolution( move.in );
+    }
+}
+
+u32 NuPDS::removeRedundant() {
+    // Smallest weighted trial losses first, these vertices observe the least on their own
+    refreshLosses();
+    redundant_.clear();
+    for ( auto v = remove_queue_.front(); v != BucketQueue::NONE; v = remove_queue_.successor( v ) ) {
+        redundant_.push_back( v );
+    }
+    // Every test above is against the full solution. Dropping vertices only shrinks the observed set,
+    // so a vertex that is not removable now never becomes removable; the survivors can still depend
+    // on each other and are confirmed one by one
+    filterRemovable( redundant_ );
+    u32 removed = 0;
+    for ( auto v : redundant_ ) {
+        if ( isRemovable( pds_graph_, v ) ) {
+            removeFromSolution( v );
+            removed++;
+        }
+    }
+    return removed;
+}
+
+std::pair<PDSGraph::Vertex, double> NuPDS::selectVertexToRemove() {
+    refreshLosses();
+    // Propagation reaches past the vertices `refreshLosses` recomputes, so queued losses can be
+    // stale. The minimum is re-keyed until its loss is current; a re-keyed vertex stays current
+    // while nothing moves, so this ends after at most one pass over the queue
+    while ( true ) {
+        // The tabu vertex goes back only when it is the last one
+        auto best = remove_queue_.min( tabu_vertex_.value_or( BucketQueue::NONE ) );
+        if ( best == BucketQueue::NONE ) {
+            best = remove_queue_.min();
+        }
+        auto loss = weightedLoss( best );
+        if ( loss == remove_queue_.key( best ) ) {
+            return { best, loss };
+        }
+        remove_queue_.update( best, loss, time_stamp_[best] );
+    }
+}
+
+u64 NuPDS::weightedLoss( PDSGraph::Vertex v ) {
+    auto cp = pds_graph_.checkpoint();
+    u64 loss = 0;
+    for ( auto w : pds_graph_.removeDominating( v ) ) {
+        loss += weight_[w];
+    }
+    pds_graph_.rollback( cp );
+    return loss;
+}
+
+void NuPDS::refreshLosses() {
+    for ( auto v : loss_stale_ ) {
+        if ( remove_available_vertices_.contains( v ) ) {
+            remove_queue_.update( v, weightedLoss( v ), time_stamp_[v] );
+        }
+    }
+    loss_stale_.clear();
+}
+
+std::pair<PDSGraph::Vertex, double> NuPDS::selectVertexToRepair() {
+    // Adding any vertex of N[x] observes the unobserved vertex `x`
+    auto x = unobserved_[rng_.nextBounded( unobserved_.size() )];
+    candidates_.clear();
+    if ( add_available_vertices_.contains( x ) ) {
+        candidates_.push_back( x );
+    }
+    for ( auto& w : pds_graph_.neighbors( x ) ) {
+        if ( add_available_vertices_.contains( w ) ) {
+            candidates_.push_back( w );
+        }
+    }
+
+    std::optional<PDSGraph::Vertex> best;
+    double maxn = 0;
+    for ( bool check : { true, false } ) {
+        for ( auto v : candidates_ ) {
+            if ( check && !conf_change_[v] ) {
+                continue;
+            }
+            double score = weightedGain( v );
+            if ( !best || score > maxn || ( score == maxn && time_stamp_[v] < time_stamp_[*best] ) ) {
+                maxn = score;
+                best = v;
             }
         }
+        if ( best ) {
+            return { *best, maxn };
+        }
+    }
+    return getMaxObserved();
+}
+
+u64 NuPDS::weightedGain( PDSGraph::Vertex v ) {
+    auto cp = pds_graph_.checkpoint();
+    u64 gain = 0;
+    for ( auto w : pds_graph_.setDominating( v ) ) {
+        gain += weight_[w];
+    }
+    pds_graph_.rollback( cp );
+    return gain;
+}
+
+void NuPDS::getClouser( std::span<const PDSGraph::Vertex> newly_observed ) {
+    clouser_.clear();
+    in_clouser_.clear();
+    auto insert = [this]( PDSGraph::Vertex v ) {
+        if ( !in_clouser_.contains( v ) ) {
+            in_clouser_.insert( v );
+            clouser_.push_back( v );
+        }
+    };
+    for ( auto& v : newly_observed ) {
+        insert( v );
+        for ( auto& w : pds_graph_.neighbors( v ) ) {
+            insert( w );
+        }
     }
 }
 
-void NuPDS::updateAfterDominating( PDSGraph::Vertex vertex, double score,
-                                   mpgraphs::set<PDSGraph::Vertex>& newly_observed ) {
-    mpgraphs::set<PDSGraph::Vertex> clouser;
-    getClouser( vertex, clouser, newly_observed );
-    for ( auto v : add_available_vertices_ ) {
-        if ( !pds_graph_.isUpdate( v ) && !pds_graph_.isDominating( v ) ) {
-            // Judge whether `v` is effect by `clouser`(i.e. is there any neighbor of `v` in `clouser`)
-            for ( auto& w : pds_graph_.graph_.neighbors( v ) ) {
-                if ( clouser.contains( w ) ) {
-                    pds_graph_.setUpdate( v );
-                    break;
-                }
+void NuPDS::invalidateScores() {
+    // Propagation can change the score of a vertex far from `clouser_`, so the cache is approximate:
+    // only the vertices next to it are marked stale here, and the greedy choice re-evaluates the
+    // vertex it picks. Vertices off the frontier are skipped, `growFrontier` marks them stale when
+    // they come back.
+    // Losses are recomputed for the dominating vertices next to the closure; losses further away may
+    // lag until one of these is touched
+    for ( auto w : clouser_ ) {
+        for ( auto& v : pds_graph_.neighbors( w ) ) {
+            if ( pds_graph_.isDominating( v ) ) {
+                loss_stale_.insert( v );
+            }
+            if ( !pds_graph_.isUpdate( v ) && !pds_graph_.isDominating( v ) &&
+                 frontier_.contains( v ) && add_available_vertices_.contains( v ) ) {
+                pds_graph_.setUpdate( v );
             }
         }
     }
+}
+
+bool NuPDS::onFrontier( PDSGraph::Vertex vertex ) const {
+    return !pds_graph_.isObserved( vertex ) || pds_graph_.unobservedDegree( vertex ) > 0;
+}
+
+void NuPDS::shrinkFrontier( std::span<const PDSGraph::Vertex> newly_observed ) {
+    // A vertex can only leave the frontier when it or one of its neighbors was observed
+    auto check = [this]( PDSGraph::Vertex v ) {
+        if ( frontier_.contains( v ) && !onFrontier( v ) ) {
+            frontier_.erase( v );
+        }
+    };
+    for ( auto x : newly_observed ) {
+        check( x );
+        for ( auto& w : pds_graph_.neighbors( x ) ) {
+            check( w );
+        }
+    }
+}
+
+void NuPDS::growFrontier( std::span<const PDSGraph::Vertex> lost ) {
+    // Scores of vertices off the frontier are not maintained, so returning vertices start out stale
+    auto check = [this]( PDSGraph::Vertex v ) {
+        if ( onFrontier( v ) && frontier_.insert( v ) ) {
+            pds_graph_.setUpdate( v );
+        }
+    };
+    for ( auto x : lost ) {
+        check( x );
+        for ( auto& w : pds_graph_.neighbors( x ) ) {
+            check( w );
+        }
+    }
+}
+
+void NuPDS::updateAfterDominating( PDSGraph::Vertex vertex,
+                                   std::span<const PDSGraph::Vertex> newly_observed ) {
+    getClouser( newly_observed );
+    invalidateScores();
+    shrinkFrontier( newly_observed );
     add_available_vertices_.erase( vertex );
-    pds_graph_.graph_[vertex].state = VertexState::Domating;
-    remove_available_vertices_.insert( { vertex, score } );
+    remove_available_vertices_.insert( vertex );
+    loss_stale_.insert( vertex );
+
+    for ( auto& w : pds_graph_.neighbors( vertex ) ) {
+        conf_change_[w] = true;
+    }
+    time_stamp_[vertex] = step_;
+    tabu_vertex_ = vertex;
+}
+
+void NuPDS::updateAfterRemoving( PDSGraph::Vertex vertex, std::span<const PDSGraph::Vertex> lost ) {
+    getClouser( lost );
+    growFrontier( lost );
+    invalidateScores();
+    remove_available_vertices_.erase( vertex );
+    remove_queue_.erase( vertex );
+    loss_stale_.erase( vertex );
+    add_available_vertices_.insert( vertex );
+    pds_graph_.setUpdate( vertex );
+
+    conf_change_[vertex] = false;
+    for ( auto& w : pds_graph_.neighbors( vertex ) ) {
+        conf_change_[w] = true;
+    }
+    time_stamp_[vertex] = step_;
+}
+
+std::span<const PDSGraph::Vertex> NuPDS::addToSolution( PDSGraph::Vertex vertex ) {
+    auto newly_observed = pds_graph_.setDominating( vertex );
+    updateAfterDominating( vertex, newly_observed );
+    logMove( vertex, true );
+    return newly_observed;
+}
+
+void NuPDS::removeFromSolution( PDSGraph::Vertex vertex ) {
+    auto lost = pds_graph_.removeDominating( vertex );
+    updateAfterRemoving( vertex, lost );
+    // Re-observed vertices may now depend on the dominating vertices next to them
+    for ( auto w : pds_graph_.lastObserved() ) {
+        for ( auto& u : pds_graph_.neighbors( w ) ) {
+            if ( pds_graph_.isDominating( u ) ) {
+                loss_stale_.insert( u );
+            }
+        }
+    }
+    logMove( vertex, false );
+}
+
+void NuPDS::setEvaluationThreads( u32 threads ) {
+    if ( threads > 1 ) {
+        pool_ = EvaluationPool( threads );
+        scratch_.assign( threads - 1, pds_graph_ );
+    } else {
+        pool_ = EvaluationPool();
+        scratch_.clear();
+    }
+    pending_moves_.clear();
+    replicas_stale_ = false;
+}
+
+void NuPDS::logMove( PDSGraph::Vertex vertex, bool add ) {
+    if ( !pool_ || replicas_stale_ ) {
+        return;
+    }
+    if ( pending_moves_.size() >= MAX_PENDING_MOVES ) {
+        pending_moves_.clear();
+        replicas_stale_ = true;
+        return;
+    }
+    pending_moves_.emplace_back( vertex, add );
+}
+
+void NuPDS::refreshReplicas() {
+    // Copied here rather than by the helper threads, thread 0 trials on `pds_graph_` meanwhile
+    if ( replicas_stale_ ) {
+        scratch_.assign( scratch_.size(), pds_graph_ );
+        replicas_stale_ = false;
+    }
+}
+
+void NuPDS::updateWeights() {
+    // NuMVC forgetting: once the average weight exceeds |V| / 2, scale all weights by 0.3
+    constexpr u32 FORGET_NUMERATOR = 3, FORGET_DENOMINATOR = 10;
+    for ( auto v : unobserved_ ) {
+        weight_[v] += 1;
+    }
+    total_weight_ += unobserved_.size();
+    u64 n = pds_graph_.graph_.numVertices();
+    if ( total_weight_ > n * n / 2 ) {
+        total_weight_ = 0;
+        for ( auto v : pds_graph_.graph_.vertices() ) {
+            weight_[v] = std::max<u32>( 1, weight_[v] * FORGET_NUMERATOR / FORGET_DENOMINATOR );
+            total_weight_ += weight_[v];
+        }
+        for ( auto v : remove_available_vertices_ ) {
+            loss_stale_.insert( v );
+        }
+    }
+}
+
+void NuPDS::updateBestSolution() {
+    // Only materialize the solution when it is smaller
+    if ( best_solution_.empty() ||
+         pds_graph_.getDominatingCount() + insured_count_ < best_solution_.size() ) {
+        best_solution_ = currentSolution();
+        last_improvement_ = step_;
+        if ( shared_best_ ) {
+            shared_best_->offer( best_solution_.size() );
+        }
+    }
+}
+
+bool NuPDS::fallenBehind() const {
+    // Give up on a run which stagnates clearly above the best solution of the portfolio
+    constexpr u64 STAGNATION_STEPS = 1000;
+    constexpr u32 SLACK_DENOMINATOR = 20;
+    if ( !shared_best_ || step_ - last_improvement_ < STAGNATION_STEPS ) {
+        return false;
+    }
+    u32 shared = shared_best_->get();
+    return best_solution_.size() > shared + std::max<u32>( 1, shared / SLACK_DENOMINATOR );
+}
+
+void NuPDS::restart() {
+    while ( !remove_available_vertices_.empty() ) {
+        auto v = remove_available_vertices_[0];
+        removeFromSolution( v );
+    }
+    total_weight_ = 0;
+    for ( auto v : pds_graph_.graph_.vertices() ) {
+        weight_[v] = 1;
+        total_weight_ += 1;
+    }
+    tabu_vertex_.reset();
+    GRASP();
+    removeRedundant();
+    applySwaps();
+    // The abandoned run is behind the portfolio's best, so its solution is not needed anymore
+    best_solution_.clear();
+    updateBestSolution();
+}
+
+bool NuPDS::boundReached() const {
+    size_t best = best_solution_.empty() ? std::numeric_limits<size_t>::max() : best_solution_.size();
+    if ( shared_best_ ) {
+        best = std::min<size_t>( best, shared_best_->get() );
+    }
+    return best <= lower_bound_;
 }
 
-// void NuPDS::updateAfterRemoving( Vertex vertex ) { remove_available_vertices_.erase( vertex ); }
+bool NuPDS::timeout() const {
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time_ ).count() >=
+           cutoff_;
+}
+
+void NuPDS::setCutoff( double seconds, u64 iterations ) {
+    cutoff_ = seconds;
+    max_iterations_ = iterations;
+}
 
 void NuPDS::GRASP() {
     // 1. Select a vertex randomly and add it into solution
@@ -138,108 +609,281 @@ void NuPDS::GRASP() {
     // vertices til it is fealible)
     bool first = true;
     while ( !pds_graph_.allObserved() ) {
-        auto [v, score] = selectVertexToAdd( first );
+        auto [v, _] = selectVertexToAdd( first );
+        if ( v == NONE ) {
+            break;
+        }
         first = false;
-        auto newly_observed = pds_graph_.setDominating( v );
-        updateAfterDominating( v, score, newly_observed );
-        std::cout << "Select Dominating Vertex: " << v << std::endl;
-        std::cout << "\tNewly Observed: " << newly_observed.size() << std::endl;
-        std::cout << "\tTotal: " << pds_graph_.graph_.numVertices() << std::endl;
-        std::cout << "\tObserved: " << pds_graph_.numObserved() << std::endl;
-        std::cout << "\tDominating: " << pds_graph_.getDominatingCount() << std::endl;
+        auto newly_observed = addToSolution( v );
+        if ( verbose_ ) {
+            std::cout << "Select Dominating Vertex: " << v << std::endl;
+            std::cout << "\tNewly Observed: " << newly_observed.size() << std::endl;
+            std::cout << "\tTotal: " << pds_graph_.graph_.numVertices() << std::endl;
+            std::cout << "\tObserved: " << pds_graph_.numObserved() << std::endl;
+            std::cout << "\tDominating: " << pds_graph_.getDominatingCount() << std::endl;
+        }
         if ( first ) {
             first = false;
         }
     }
 }
 
-void NuPDS::localSearch() {}
+void NuPDS::localSearch() {
+    auto collectUnobserved = [this]() {
+        unobserved_.clear();
+        for ( auto v : frontier_ ) {
+            if ( !pds_graph_.isObserved( v ) ) {
+                unobserved_.push_back( v );
+            }
+        }
+    };
+
+    while ( step_ < max_iterations_ && !timeout() && !boundReached() ) {
+        if ( fallenBehind() ) {
+            restart();
+        }
+        if ( pds_graph_.allObserved() ) {
+            updateBestSolution();
+            if ( remove_available_vertices_.empty() ) {
+                break;
+            }
+            auto [v, _] = selectVertexToRemove();
+            // A 2-1 swap around the cheapest vertex stays feasible with one vertex less
+            auto move = moves_.findTwoForOne( pds_graph_, v, swap_policy_ );
+            if ( move && isAllowed( *move ) ) {
+                applyMove( *move );
+            } else {
+                removeFromSolution( v );
+            }
+            continue;
+        }
+
+        // A 1-1 swap gaining more weight than it loses replaces the removal and the repair. The
+        // entering vertex passes the configuration check and tabu of a repair after removing `out`,
+        // which changes the configuration of its neighbors
+        std::optional<MoveEngine::Move> swap;
+        if ( !remove_available_vertices_.empty() ) {
+            auto out = selectVertexToRemove().first;
+            auto allowed = [this, out]( PDSGraph::Vertex v ) {
+                return ( conf_change_[v] || pds_graph_.adjacent( out, v ) ) && v != tabu_vertex_ &&
+                       add_available_vertices_.contains( v );
+            };
+            swap = moves_.findSwap( pds_graph_, out, swap_policy_, weight_, allowed );
+            if ( swap ) {
+                applyMove( *swap );
+            } else {
+                removeFromSolution( out );
+            }
+        }
+
+        if ( !swap ) {
+            collectUnobserved();
+            auto [v, _] = selectVertexToRepair();
+            if ( v != NONE ) {
+                addToSolution( v );
+            }
+        }
+
+        collectUnobserved();
+        updateWeights();
+        step_++;
+    }
+}
 
 void NuPDS::search() {
+    start_time_ = std::chrono::steady_clock::now();
+    proven_optimal_ = false;
+    insured_count_ = 0;
+    for ( auto v : pds_graph_.graph_.vertices() ) {
+        insured_count_ += pds_graph_.isInSured( v );
+    }
+    LowerBound bound( pds_graph_ );
+    lower_bound_ = bound.value();
+    if ( verbose_ ) {
+        std::cout << "Lower Bound: " << lower_bound_ << " (" << bound.numSpiders() << " spiders, "
+                  << bound.numComponents() << " components)" << std::endl;
+    }
+    std::optional<PDSGraph> base;
+    std::vector<PDSGraph::Vertex> candidates;
+    if ( exact_threads_ > 0 ) {
+        base.emplace( pds_graph_ );
+        candidates.assign( add_available_vertices_.begin(), add_available_vertices_.end() );
+    }
     GRASP();
-    // NOTE For Debugging
-    return;
-
-    // u32 timestramp = 0;
-    // while ( timestramp < cutoff_ ) {
-    //     if ( allObserved() ) {
-    //         best_solution = graph_.vertices() | ranges::views::filter( [this]( auto v ) {
-    //                             return graph_[v].state == VertexState::Domating ||
-    //                                    graph_[v].state == VertexState::InSured;
-    //                         } ) |
-    //                         ranges::to<std::vector>();
-    //         // TODO random select a vertex to remove
-    //         auto index = random_int( 0, remove_available_vertices_.size() );
-    //         auto v = remove_available_vertices_.at( index );
-    //         removeDominating( v );
-    //         continue;
-    //     }
-    //     // auto [v, _] = selectVertexToRemove();
-    //     // removeDominating( v );
-    //     // auto [u, score] = selectVertexToAdd();
-    //     // setDominating( u );
-    //     // updateAfterDominating( u, score );
-    //     timestramp += 1;
-    // }
-}
-
-void NuPDS::init( std::ifstream& fin ) {
-    int n, m;
-    fin >> n >> m;
-    mpgraphs::map<u32, Graph::VertexDescriptor> vertices;
-    for ( int v = 0; v < n; v++ ) {
-        // u32 v;
-        // fin >> v;
-        vertices[v] = pds_graph_.graph_.addVertex( Node{ .name = std::to_string( v ),
-                                                         .id = static_cast<u32>( v ),
-                                                         .non_propgating = false,
-                                                         .update = false,
-                                                         .state = VertexState::Blank } );
-        add_available_vertices_.insert( vertices[v] );
-    }
-    auto getVertex = [&vertices]( auto i ) {
-        if ( !vertices.contains( i ) ) throw std::exception();
-        return vertices[i];
-    };
+    auto redundant = removeRedundant();
+    auto swaps = applySwaps();
+    if ( verbose_ ) {
+        std::cout << "Redundant Dominating Vertices: " << redundant << std::endl;
+        std::cout << "2-1 Swaps: " << swaps << std::endl;
+    }
+    updateBestSolution();
+    if ( boundReached() ) {
+        // Nothing left to improve, or another portfolio worker already has an optimal solution
+    } else if ( base ) {
+        exactSearch( *base, candidates );
+        if ( !proven_optimal_ ) {
+            localSearch();
+        }
+    } else {
+        localSearch();
+    }
+    proven_optimal_ = proven_optimal_ || best_solution_.size() <= lower_bound_;
+    if ( verbose_ ) {
+        std::cout << "Proven Optimal: " << proven_optimal_ << std::endl;
+    }
+}
 
-    for ( int i = 0; i < m; i++ ) {
-        u32 u, v;
-        fin >> u >> v;
-        pds_graph_.graph_.addEdge( getVertex( u ), getVertex( v ) );
+void NuPDS::exactSearch( const PDSGraph& base, std::span<const PDSGraph::Vertex> candidates ) {
+    ExactSolver exact( base, candidates, best_solution_, exact_threads_ );
+    exact.setLowerBound( lower_bound_ );
+    auto elapsed =
+        std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time_ ).count();
+    proven_optimal_ = exact.solve( std::max( 0.0, cutoff_ - elapsed ) * EXACT_SHARE );
+    if ( exact.getSolution().size() < best_solution_.size() ) {
+        best_solution_ = exact.getSolution();
     }
+    if ( verbose_ ) {
+        std::cout << "Branch and Bound Nodes: " << exact.numNodes() << std::endl;
+    }
+}
 
-    // int k;
-    // fin >> k;
+void NuPDS::init( std::ifstream& fin ) { init( Instance::read( fin ) ); }
 
-    // for ( int i = 0; i < k; i++ ) {
-    //     u32 v;
-    //     fin >> v;
-    //     pds_graph_.graph_.getVertex( getVertex( v ) ).state = VertexState::InSured;
-    //     pds_graph_.setDominating( getVertex( v ) );
-    // }
+void NuPDS::init( const Instance& instance ) {
+    initVertices( instance.num_vertices );
+    for ( auto [u, v] : instance.edges ) {
+        checkVertex( u );
+        checkVertex( v );
+    }
+    // Bulk build, edge by edge insertion would scan an adjacency list for duplicates every time
+    pds_graph_.assignTopology( Topology::fromEdges( instance.num_vertices, instance.edges ) );
+    initLists( instance.insured, instance.excluded, instance.non_propagating );
+}
+
+void NuPDS::init( const GraphFile& file ) {
+    initVertices( file.numVertices() );
+    pds_graph_.assignTopology( file.topology() );
+    std::vector<u32> insured, excluded, non_propagating;
+    auto flags = file.flags();
+    for ( u32 v = 0; v < flags.size(); v++ ) {
+        if ( flags[v] & GraphFile::INSURED ) {
+            insured.push_back( v );
+        }
+        if ( flags[v] & GraphFile::EXCLUDED ) {
+            excluded.push_back( v );
+        }
+        if ( flags[v] & GraphFile::NON_PROPAGATING ) {
+            non_propagating.push_back( v );
+        }
+    }
+    initLists( insured, excluded, non_propagating );
+}
 
-    // fin >> k;
+void NuPDS::initVertices( u32 n ) {
+    add_available_vertices_.reserve( n );
+    remove_available_vertices_.reserve( n );
+    frontier_.reserve( n );
+    remove_queue_.resize( n );
+    loss_stale_.reserve( n );
+    for ( u32 i = 0; i < n; i++ ) {
+        auto v = pds_graph_.addVertex( Node{ .id = i } );
+        pds_graph_.setUpdate( v );
+        add_available_vertices_.insert( v );
+        frontier_.insert( v );
+        score_cache_[v] = 0;
+        weight_[v] = 1;
+        conf_change_[v] = true;
+        time_stamp_[v] = 0;
+    }
+    total_weight_ = n;
+}
 
-    // for ( int i = 0; i < k; i++ ) {
-    //     u32 v;
-    //     fin >> v;
-    //     pds_graph_.graph_.getVertex( getVertex( v ) ).state = VertexState::Exclude;
-    //     add_available_vertices_.erase( getVertex( v ) );
-    // }
+PDSGraph::Vertex NuPDS::checkVertex( u32 id ) const {
+    // Vertices are added in input order, so descriptors are the input ids
+    if ( !pds_graph_.graph_.hasVertex( id ) ) throw std::exception();
+    return id;
+}
 
-    // fin >> k;
+void NuPDS::initLists( std::span<const u32> insured, std::span<const u32> excluded,
+                       std::span<const u32> non_propagating ) {
+    // The propagation from the insured vertices depends on the other two lists, so they go last
+    for ( auto v : non_propagating ) {
+        pds_graph_.setNonPropagating( checkVertex( v ) );
+    }
+    for ( auto v : excluded ) {
+        pds_graph_.setExclude( checkVertex( v ) );
+        add_available_vertices_.erase( checkVertex( v ) );
+    }
+    if ( !insured.empty() ) {
+        std::vector<PDSGraph::Vertex> vertices;
+        for ( auto v : insured ) {
+            vertices.push_back( checkVertex( v ) );
+            add_available_vertices_.erase( checkVertex( v ) );
+        }
+        shrinkFrontier( pds_graph_.setInSured( vertices ) );
+    }
+    // Without excluded vertices every vertex can observe itself
+    if ( !excluded.empty() ) {
+        checkFeasible();
+    }
+}
 
-    // for ( int i = 0; i < k; i++ ) {
-    //     u32 v;
-    //     fin >> v;
-    //     pds_graph_.graph_.getVertex( getVertex( v ) ).non_propgating = true;
-    // }
+void NuPDS::checkFeasible() {
+    // Observation only grows with the dominating set, so if dominating every allowed vertex at once
+    // leaves a vertex unobserved, no solution observes it
+    auto cp = pds_graph_.checkpoint();
+    std::vector<PDSGraph::Vertex> all( add_available_vertices_.begin(), add_available_vertices_.end() );
+    pds_graph_.setInSured( all );
+    std::optional<PDSGraph::Vertex> unobservable;
+    if ( !pds_graph_.allObserved() ) {
+        for ( auto v : pds_graph_.graph_.vertices() ) {
+            if ( !pds_graph_.isObserved( v ) ) {
+                unobservable = v;
+                break;
+            }
+        }
+    }
+    pds_graph_.rollback( cp );
+    if ( unobservable ) {
+        throw std::runtime_error( "no solution: vertex " + std::to_string( *unobservable ) +
+                                  " cannot be observed without excluded vertices" );
+    }
 }
 
-std::vector<unsigned long> NuPDS::getSolution() {
+std::vector<PDSGraph::Vertex> NuPDS::currentSolution() {
     return pds_graph_.graph_.vertices() | ranges::views::filter( [this]( auto v ) {
-               return pds_graph_.graph_[v].state == VertexState::Domating ||
-                      pds_graph_.graph_[v].state == VertexState::InSured;
+               return pds_graph_.isDominating( v ) || pds_graph_.isInSured( v );
            } ) |
-           ranges::to<std::vector>();
+           ranges::to<std::vector<PDSGraph::Vertex>>();
+}
+
+std::vector<unsigned long> NuPDS::getSolution() {
+    if ( best_solution_.empty() ) {
+        updateBestSolution();
+    }
+    auto solution = best_solution_;
+    reduction_.lift( solution );
+    return solution | ranges::to<std::vector<unsigned long>>();
+}
+
+void NuPDS::preProcess() {
+    auto removed = reduction_.apply( pds_graph_ );
+    for ( auto [rule, v] : reduction_.log() ) {
+        add_available_vertices_.erase( v );
+        if ( rule != Reduction::Rule::ExcludeLeaf ) {
+            frontier_.erase( v );
+        }
+    }
+    if ( pds_graph_.topology_stale_ ) {
+        pds_graph_.freeze();
+    }
+    if ( pool_ ) {
+        scratch_.assign( scratch_.size(), pds_graph_ );
+        pending_moves_.clear();
+        replicas_stale_ = false;
+    }
+    if ( verbose_ ) {
+        std::cout << "Reduced Vertices: " << removed << std::endl;
+        std::cout << "Reduction Steps: " << reduction_.log().size() << std::endl;
+    }
 }
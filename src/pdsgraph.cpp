@@ -1,29 +1,59 @@
 #include "pdsgraph.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <exception>
 #include <iostream>
+#include <iterator>
 #include <optional>
 #include <range/v3/range/conversion.hpp>
 #include <utility>
 #include <vector>
 
 PDSGraph::PDSGraph( PDSGraph& graph )
-    : unobserved_degree_( graph.unobserved_degree_ ),
+    : state_( graph.state_ ),
+      flags_( graph.flags_ ),
+      unobserved_degree_( graph.unobserved_degree_ ),
       dominating_count_( graph.dominating_count_ ),
       graph_( graph.graph_ ),
-      dependencies_( graph.dependencies_ ) {}
+      dependencies_( graph.dependencies_ ),
+      topology_( graph.topology_ ),
+      topology_stale_( graph.topology_stale_ ),
+      edges_pending_( graph.edges_pending_ ) {}
 
 PDSGraph::PDSGraph( const PDSGraph& graph )
-    : unobserved_degree_( graph.unobserved_degree_ ),
+    : state_( graph.state_ ),
+      flags_( graph.flags_ ),
+      unobserved_degree_( graph.unobserved_degree_ ),
       dominating_count_( graph.dominating_count_ ),
       graph_( graph.graph_ ),
-      dependencies_( graph.dependencies_ ) {}
+      dependencies_( graph.dependencies_ ),
+      topology_( graph.topology_ ),
+      topology_stale_( graph.topology_stale_ ),
+      edges_pending_( graph.edges_pending_ ) {}
+
+PDSGraph::Vertex PDSGraph::addVertex( Node node ) {
+    materialize();
+    auto v = graph_.addVertex( std::move( node ) );
+    if ( v >= state_.size() ) {
+        state_.resize( v + 1, VertexState::Blank );
+        flags_.resize( v + 1, 0 );
+        unobserved_degree_.resize( v + 1, 0 );
+        dependencies_.resize( v + 1 );
+    }
+    state_[v] = VertexState::Blank;
+    flags_[v] = 0;
+    unobserved_degree_[v] = 0;
+    topology_stale_ = true;
+    return v;
+}
 
 void PDSGraph::addEdge( Vertex source, Vertex target ) {
     assert( source != target );
+    materialize();
     if ( !graph_.edge( source, target ) ) {
         graph_.addEdge( source, target );
+        topology_stale_ = true;
         if ( !isObserved( source ) ) {
             unobserved_degree_[target] += 1;
         }
@@ -34,46 +64,172 @@ void PDSGraph::addEdge( Vertex source, Vertex target ) {
 }
 
 void PDSGraph::removeVertex( Vertex v ) {
+    materialize();
     if ( !isObserved( v ) ) {
         for ( auto& w : graph_.neighbors( v ) ) {
             unobserved_degree_[w] -= 1;
         }
     }
-    dependencies_.removeVertex( v );
+    if ( isObserved( v ) ) {
+        removeObserved( v );
+    }
     graph_.removeVertex( v );
-    unobserved_degree_.erase( v );
+    unobserved_degree_[v] = 0;
+    topology_stale_ = true;
+}
+
+void PDSGraph::freeze() {
+    if ( edges_pending_ ) {
+        return;
+    }
+    topology_ = Topology::fromGraph( graph_, state_.size() );
+    topology_stale_ = false;
+}
+
+void PDSGraph::assignTopology( Topology topology ) {
+    assert( numObserved() == 0 && graph_.numEdges() == 0 && topology.numVertices() == state_.size() );
+    for ( auto v : graph_.vertices() ) {
+        unobserved_degree_[v] = topology.degree( v );
+    }
+    topology_ = std::move( topology );
+    topology_stale_ = false;
+    edges_pending_ = true;
+}
+
+void PDSGraph::materialize() {
+    if ( edges_pending_ ) {
+        graph_.assignEdges( topology_ );
+        edges_pending_ = false;
+    }
+}
+
+PDSGraph::Vertex PDSGraph::neighbor( Vertex v, u32 i ) const {
+    if ( edges_pending_ ) {
+        return topology_.neighbors( v )[i];
+    }
+    return *std::next( graph_.neighbors( v ).begin(), i );
+}
+
+bool PDSGraph::adjacent( Vertex u, Vertex v ) const {
+    if ( edges_pending_ ) {
+        auto list = topology_.neighbors( u );
+        return std::binary_search( list.begin(), list.end(), v );
+    }
+    return graph_.edge( u, v ).has_value();
+}
+
+PDSGraph::Checkpoint PDSGraph::checkpoint() {
+    open_checkpoints_++;
+    return { trail_.size(), dominating_count_ };
+}
+
+void PDSGraph::rollback( const Checkpoint& cp ) {
+    assert( open_checkpoints_ > 0 && trail_.size() >= cp.trail );
+    while ( trail_.size() > cp.trail ) {
+        auto [op, v, aux] = trail_.back();
+        trail_.pop_back();
+        switch ( op ) {
+            case TrailOp::State:
+                state_[v] = static_cast<VertexState>( aux );
+                break;
+            case TrailOp::IncUnobserved:
+                unobserved_degree_[v] -= 1;
+                break;
+            case TrailOp::DecUnobserved:
+                unobserved_degree_[v] += 1;
+                break;
+            case TrailOp::Observe:
+                dependencies_.unobserve( v );
+                break;
+            case TrailOp::Unobserve:
+                dependencies_.observe( v );
+                break;
+            case TrailOp::AddObserverEdge:
+                dependencies_.cut( v );
+                break;
+            case TrailOp::RemoveObserverEdge:
+                dependencies_.link( aux, v );
+                break;
+        }
+    }
+    dominating_count_ = cp.dominating_count;
+    open_checkpoints_--;
+}
+
+void PDSGraph::setState( Vertex v, VertexState state ) {
+    record( TrailOp::State, v, static_cast<Vertex>( state_[v] ) );
+    state_[v] = state;
+}
+
+void PDSGraph::incUnobserved( Vertex v ) {
+    record( TrailOp::IncUnobserved, v );
+    unobserved_degree_[v] += 1;
+}
+
+void PDSGraph::decUnobserved( Vertex v ) {
+    record( TrailOp::DecUnobserved, v );
+    unobserved_degree_[v] -= 1;
+}
+
+void PDSGraph::addObserved( Vertex v ) {
+    record( TrailOp::Observe, v );
+    dependencies_.observe( v );
+}
+
+void PDSGraph::removeObserved( Vertex v ) {
+    // Edges are journaled one by one so that rollback can restore them after the vertex.
+    while ( dependencies_.hasChildren( v ) ) {
+        removeObserverEdge( v, dependencies_.firstChild( v ) );
+    }
+    if ( !dependencies_.isRoot( v ) ) {
+        removeObserverEdge( dependencies_.parent( v ), v );
+    }
+    record( TrailOp::Unobserve, v );
+    dependencies_.unobserve( v );
 }
 
-void PDSGraph::propagate( std::vector<Vertex>& queue, mpgraphs::set<Vertex>& newlyObserved ) {
-    while ( !queue.empty() ) {
-        auto v = queue.back();
-        queue.pop_back();
+void PDSGraph::addObserverEdge( Vertex source, Vertex target ) {
+    record( TrailOp::AddObserverEdge, target, source );
+    dependencies_.link( source, target );
+}
+
+void PDSGraph::removeObserverEdge( Vertex source, Vertex target ) {
+    assert( dependencies_.hasEdge( source, target ) );
+    record( TrailOp::RemoveObserverEdge, target, source );
+    dependencies_.cut( target );
+}
+
+void PDSGraph::propagate() {
+    while ( !queue_.empty() ) {
+        auto v = queue_.back();
+        queue_.pop_back();
         if ( isObserved( v ) && !isNonPropagating( v ) && unobserved_degree_[v] == 1 ) {
-            for ( auto& w : graph_.neighbors( v ) ) {
+            for ( auto& w : topology_.neighbors( v ) ) {
                 if ( !isObserved( w ) ) {
-                    observeOne( w, v, queue, newlyObserved );
+                    observeOne( w, v );
                 }
             }
         }
     }
 }
 
-bool PDSGraph::observeOne( Vertex vertex, Vertex origin, std::vector<Vertex>& queue,
-                           mpgraphs::set<Vertex>& newlyObserved ) {
+bool PDSGraph::observeOne( Vertex vertex, Vertex origin ) {
     if ( !isObserved( vertex ) ) {
-        dependencies_.getOrAddVertex( vertex );
-        newlyObserved.insert( vertex );
-        graph_[vertex].state = VertexState::Observed;
+        addObserved( vertex );
+        observed_.push_back( vertex );
+        if ( isBlack( vertex ) ) {
+            setState( vertex, VertexState::Observed );
+        }
         if ( origin != vertex ) {
-            dependencies_.addEdge( origin, vertex );
+            addObserverEdge( origin, vertex );
         }
         if ( unobserved_degree_[vertex] == 1 ) {
-            queue.push_back( vertex );
+            queue_.push_back( vertex );
         }
-        for ( auto& w : graph_.neighbors( vertex ) ) {
-            unobserved_degree_[w] -= 1;
+        for ( auto& w : topology_.neighbors( vertex ) ) {
+            decUnobserved( w );
             if ( unobserved_degree_[w] == 1 && isObserved( w ) && !isNonPropagating( w ) ) {
-                queue.push_back( w );
+                queue_.push_back( w );
             }
         }
         return true;
@@ -82,69 +238,121 @@ bool PDSGraph::observeOne( Vertex vertex, Vertex origin, std::vector<Vertex>& qu
     }
 }
 
-mpgraphs::set<PDSGraph::Vertex> PDSGraph::setDominating( Vertex vertex ) {
-    mpgraphs::set<Vertex> newlyObserved;
+std::span<const PDSGraph::Vertex> PDSGraph::setDominating( Vertex vertex ) {
+    observed_.clear();
+    if ( topology_stale_ ) {
+        freeze();
+    }
     if ( !isDominating( vertex ) ) {
-        graph_[vertex].state = VertexState::Domating;
+        setState( vertex, VertexState::Domating );
         dominating_count_++;
-        if ( dependencies_.hasVertex( vertex ) ) {
-            while ( dependencies_.inDegree( vertex ) > 0 ) {
-                auto e = *dependencies_.inEdges( vertex ).begin();
-                dependencies_.removeEdge( e );
-            }
+        if ( isObserved( vertex ) && !dependencies_.isRoot( vertex ) ) {
+            removeObserverEdge( dependencies_.parent( vertex ), vertex );
         }
-        std::vector<Vertex> queue;
-        observeOne( vertex, vertex, queue, newlyObserved );
-        for ( auto w : graph_.neighbors( vertex ) ) {
-            observeOne( w, vertex, queue, newlyObserved );
-        }
-        propagate( queue, newlyObserved );
-    }
-    return newlyObserved;
-}
-
-bool PDSGraph::removeDominating( Vertex vertex ) {
-    mpgraphs::set<Vertex> newlyObserved;
-    if ( isDominating( vertex ) ) {
-        std::vector<Vertex> queue;
-        std::vector<Vertex> propagating;
-        mpgraphs::set<Vertex> enqueued;
-
-        graph_[vertex].state = VertexState::Blank;
-        dominating_count_--;
-        queue.push_back( vertex );
-        enqueued.insert( vertex );
-        while ( !queue.empty() ) {
-            auto v = queue.back();
-            queue.pop_back();
-            std::optional<Vertex> observer;
-            for ( auto& w : graph_.neighbors( v ) ) {
-                unobserved_degree_[w] += 1;
-                if ( !isObserved( w ) ) {
-                    if ( dependencies_.hasEdge( v, w ) ) {
-                        if ( !enqueued.contains( w ) ) {
-                            queue.push_back( w );
-                            enqueued.insert( w );
-                        }
-                    } else if ( isObserved( w ) ) {
-                        for ( auto& u : graph_.neighbors( w ) ) {
-                            if ( !enqueued.contains( u ) ) {
-                                queue.push_back( u );
-                                enqueued.insert( u );
-                            }
-                        }
-                        propagating.push_back( w );
+        queue_.clear();
+        observeOne( vertex, vertex );
+        for ( auto w : topology_.neighbors( vertex ) ) {
+            observeOne( w, vertex );
+        }
+        propagate();
+    }
+    return observed_;
+}
+
+std::span<const PDSGraph::Vertex> PDSGraph::setInSured( std::span<const Vertex> vertices ) {
+    observed_.clear();
+    if ( topology_stale_ ) {
+        freeze();
+    }
+    queue_.clear();
+    for ( auto vertex : vertices ) {
+        if ( isDominating( vertex ) ) {
+            dominating_count_--;
+        }
+        setState( vertex, VertexState::InSured );
+        if ( isObserved( vertex ) && !dependencies_.isRoot( vertex ) ) {
+            removeObserverEdge( dependencies_.parent( vertex ), vertex );
+        }
+        observeOne( vertex, vertex );
+        for ( auto w : topology_.neighbors( vertex ) ) {
+            observeOne( w, vertex );
+        }
+    }
+    // One propagation for the whole batch
+    propagate();
+    return observed_;
+}
+
+std::span<const PDSGraph::Vertex> PDSGraph::removeDominating( Vertex vertex ) {
+    lost_.clear();
+    if ( !isDominating( vertex ) ) {
+        return lost_;
+    }
+    if ( topology_stale_ ) {
+        freeze();
+    }
+    setState( vertex, VertexState::Blank );
+    dominating_count_--;
+
+    // Collect every vertex whose observation may rely on `vertex`: the ones it observed directly
+    // and, transitively, the ones propagated by a vertex that needed an invalidated neighbor.
+    invalid_.clear();
+    enqueued_.clear();
+    expanded_.clear();
+    auto invalidate = [this]( Vertex w ) {
+        if ( !enqueued_.contains( w ) ) {
+            enqueued_.insert( w );
+            invalid_.push_back( w );
+        }
+    };
+    invalidate( vertex );
+    for ( size_t i = 0; i < invalid_.size(); i++ ) {
+        auto v = invalid_[i];
+        for ( auto w : dependencies_.children( v ) ) {
+            invalidate( w );
+        }
+        for ( auto& w : topology_.neighbors( v ) ) {
+            // Children of an invalidated or already expanded `w` are all invalidated, so every `w` is
+            // expanded at most once; otherwise a high-degree vertex is rescanned from each neighbor
+            if ( isObserved( w ) && !isDominating( w ) && !isInSured( w ) && !enqueued_.contains( w ) &&
+                 !expanded_.contains( w ) ) {
+                expanded_.insert( w );
+                for ( auto u : dependencies_.children( w ) ) {
+                    if ( u != v ) {
+                        invalidate( u );
                     }
-                } else {
-                    observer = { w };
                 }
             }
-            dependencies_.removeVertex( v );
-            if ( observer.has_value() ) {
-                observeOne( v, observer.value(), propagating, newlyObserved );
+        }
+    }
+
+    for ( auto v : invalid_ ) {
+        removeObserved( v );
+        if ( state_[v] == VertexState::Observed ) {
+            setState( v, VertexState::Blank );
+        }
+        for ( auto& w : topology_.neighbors( v ) ) {
+            incUnobserved( w );
+        }
+    }
+
+    // Observe again what is still dominated and restart propagation from the border of the region
+    queue_.clear();
+    observed_.clear();
+    for ( auto v : invalid_ ) {
+        for ( auto& w : topology_.neighbors( v ) ) {
+            if ( isDominating( w ) || isInSured( w ) ) {
+                observeOne( v, w );
+            } else if ( isObserved( w ) && !isNonPropagating( w ) && unobserved_degree_[w] == 1 ) {
+                queue_.push_back( w );
             }
         }
-        propagate( propagating, newlyObserved );
     }
-    return isObserved( vertex );
-}
\ No newline at end of file
+    propagate();
+    for ( auto v : invalid_ ) {
+        if ( !isObserved( v ) ) {
+            lost_.push_back( v );
+        }
+    }
+    return lost_;
+}
@@ -0,0 +1,36 @@
+#include "portfolio.hpp"
+
+#include <thread>
+
+// Random perturbation of the `Ob` score used by the GRASP construction of each worker
+static constexpr double PERTURBATIONS[] = { 1.0, 0.5, 2.0, 0.25, 0.0, 4.0 };
+
+Portfolio::Portfolio( const NuPDS& prototype, u32 threads ) : workers_( threads, prototype ) {
+    for ( u32 i = 0; i < threads; i++ ) {
+        workers_[i].setRandom( prototype.getRandom().split( i ) );
+        workers_[i].setSharedBest( &shared_best_ );
+        workers_[i].setPerturbation( PERTURBATIONS[i % std::size( PERTURBATIONS )] );
+        workers_[i].setVerbose( false );
+    }
+}
+
+void Portfolio::search() {
+    std::vector<std::thread> threads;
+    for ( auto& worker : workers_ ) {
+        threads.emplace_back( [&worker]() { worker.search(); } );
+    }
+    for ( auto& thread : threads ) {
+        thread.join();
+    }
+}
+
+std::vector<unsigned long> Portfolio::getSolution() {
+    std::vector<unsigned long> best;
+    for ( auto& worker : workers_ ) {
+        auto solution = worker.getSolution();
+        if ( best.empty() || solution.size() < best.size() ) {
+            best = std::move( solution );
+        }
+    }
+    return best;
+}
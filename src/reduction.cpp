@@ -0,0 +1,95 @@
+#include "reduction.hpp"
+
+#include <cassert>
+
+bool Reduction::isReducible( const PDSGraph& graph, Vertex v ) {
+    return graph.isBlack( v ) && !graph.isObserved( v ) && !graph.isNonPropagating( v );
+}
+
+void Reduction::push( Vertex v ) {
+    if ( !queued_.contains( v ) ) {
+        queued_.insert( v );
+        queue_.push_back( v );
+    }
+}
+
+bool Reduction::deleteLeaf( PDSGraph& graph, Vertex v ) {
+    if ( graph.degree( v ) != 1 || !isReducible( graph, v ) ) {
+        return false;
+    }
+    Vertex u = graph.neighbor( v, 0 );
+    if ( graph.degree( u ) > 2 || !isReducible( graph, u ) ) {
+        return false;
+    }
+    graph.removeVertex( v );
+    log_.push_back( { Rule::DeleteLeaf, v } );
+    push( u );
+    for ( u32 i = 0; i < graph.degree( u ); i++ ) {
+        push( graph.neighbor( u, i ) );
+    }
+    return true;
+}
+
+bool Reduction::contractChain( PDSGraph& graph, Vertex v ) {
+    if ( graph.degree( v ) != 2 || !isReducible( graph, v ) ) {
+        return false;
+    }
+    Vertex u = graph.neighbor( v, 0 );
+    Vertex w = graph.neighbor( v, 1 );
+    // Adjacent neighbors would make this an isolated triangle, which has no shorter equivalent
+    if ( graph.degree( u ) != 2 || graph.degree( w ) != 2 || !isReducible( graph, u ) ||
+         !isReducible( graph, w ) || graph.adjacent( u, w ) ) {
+        return false;
+    }
+    graph.removeVertex( v );
+    graph.addEdge( u, w );
+    log_.push_back( { Rule::ContractChain, v } );
+    push( u );
+    push( w );
+    return true;
+}
+
+size_t Reduction::apply( PDSGraph& graph ) {
+    auto& g = graph.graph_;
+    size_t before = g.numVertices();
+    queue_.clear();
+    queued_.clear();
+    for ( auto v : g.vertices() ) {
+        push( v );
+    }
+    while ( !queue_.empty() ) {
+        auto v = queue_.back();
+        queue_.pop_back();
+        queued_.erase( v );
+        if ( g.hasVertex( v ) && !deleteLeaf( graph, v ) ) {
+            contractChain( graph, v );
+        }
+    }
+
+    // Leaves and isolated vertices are only dealt with at the fixpoint, deleting them is preferred
+    queue_.clear();
+    for ( auto v : g.vertices() ) {
+        queue_.push_back( v );
+    }
+    for ( auto v : queue_ ) {
+        if ( !isReducible( graph, v ) ) {
+            continue;
+        }
+        if ( graph.degree( v ) == 0 ) {
+            graph.removeVertex( v );
+            log_.push_back( { Rule::ForceIsolated, v } );
+        } else if ( graph.degree( v ) == 1 && graph.isBlack( graph.neighbor( v, 0 ) ) ) {
+            graph.setExclude( v );
+            log_.push_back( { Rule::ExcludeLeaf, v } );
+        }
+    }
+    return before - g.numVertices();
+}
+
+void Reduction::lift( std::vector<Vertex>& solution ) const {
+    for ( auto [rule, v] : log_ ) {
+        if ( rule == Rule::ForceIsolated ) {
+            solution.push_back( v );
+        }
+    }
+}
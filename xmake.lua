@@ -21,6 +21,21 @@ target("solver.elf")
         add_cxxflags("-flto")
     end
     add_includedirs("include")
-    add_files("src/*.cpp|checker.cpp|test.cpp")
+    add_files("src/*.cpp|checker.cpp|test.cpp|bruteforce.cpp|convert.cpp")
     add_packages("unordered_dense")
-    add_packages("fmt")
\ No newline at end of file
+    add_packages("fmt")
+    add_syslinks("pthread")
+
+target("convert.elf")
+    set_rundir("$(projectdir)")
+    set_languages("cxx20")
+    set_kind("binary")
+    set_warnings("all", "error")
+    if is_mode("release") then
+        set_optimize("fastest")
+    end
+    add_includedirs("include")
+    add_files("src/convert.cpp", "src/graphfile.cpp", "src/loader.cpp", "src/pdsgraph.cpp")
+    add_packages("unordered_dense")
+    add_packages("fmt")
+    add_syslinks("pthread")
\ No newline at end of file